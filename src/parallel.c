@@ -0,0 +1,789 @@
+#include "parallel.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define PARALLEL_BLOCKS_PER_WORKER 8
+#define PARTIAL_ALIGN 16
+#define SORT_INSERTION_MAX 32
+
+struct parallel_block;
+
+/**
+    @struct parallel_ctx
+    @brief Description d'une opération parallèle, partagée par tous ses blocs
+*/
+struct parallel_ctx {
+    void (*run)(struct parallel_block *block);  /*!<Traitement d'un bloc*/
+    parallel_for_body_t for_body;
+    parallel_reduce_body_t reduce_body;
+    parallel_combine_t combine;
+    void *arg;
+    char *data;                 /*!<Eléments traités par parallel_scan*/
+    size_t size;                /*!<Taille d'un élément ou d'un résultat partiel*/
+    const void *identity;
+};
+
+/**
+    @struct parallel_block
+    @brief Bloc d'indices traité par un thread
+*/
+struct parallel_block {
+    size_t begin;
+    size_t end;
+    struct parallel_ctx *ctx;
+    void *partial;              /*!<Résultat partiel du bloc (réduction et préfixe)*/
+};
+
+/**********************
+    Internal Functions
+***********************/
+
+/**
+ * Nombre de workers exécutant les threads : la bibliothèque n'en utilise qu'un
+ */
+static int parallel_workers(void){
+    return 1;
+}
+
+/**
+ * Découper [begin, end[ en blocs d'au plus grain indices.
+ * Les résultats partiels, de size octets chacun, sont alloués à la suite des blocs.
+ */
+static struct parallel_block *blocks_split(size_t begin, size_t end, size_t grain,
+                                           struct parallel_ctx *ctx, size_t *nblocks){
+    struct parallel_block *blocks;
+    size_t i, n = end - begin;
+    size_t stride = (ctx->size + PARTIAL_ALIGN - 1) & ~(size_t) (PARTIAL_ALIGN - 1);
+    size_t header = (sizeof(*blocks) + PARTIAL_ALIGN - 1) & ~(size_t) (PARTIAL_ALIGN - 1);
+    if (grain == PARALLEL_GRAIN_AUTO) {
+        grain = parallel_grain(n);
+    }
+    *nblocks = (n + grain - 1) / grain;
+    blocks = malloc(*nblocks * (header + stride));
+    if (blocks == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < *nblocks; i++) {
+        blocks[i].begin = begin + i * grain;
+        blocks[i].end = blocks[i].begin + grain < end ? blocks[i].begin + grain : end;
+        blocks[i].ctx = ctx;
+        blocks[i].partial = (char *) blocks + *nblocks * header + i * stride;
+        if (ctx->identity != NULL) {
+            memcpy(blocks[i].partial, ctx->identity, ctx->size);
+        }
+    }
+    return blocks;
+}
+
+/**
+ * Point d'entrée des threads de bloc
+ */
+static void *block_entry(void *arg){
+    struct parallel_block *block = arg;
+    block->ctx->run(block);
+    return NULL;
+}
+
+/**
+ * Traiter tous les blocs : un thread par bloc, créés en un lot et attendus en une fois.
+ * Un bloc unique est traité directement par l'appelant.
+ */
+static int blocks_run(struct parallel_block *blocks, size_t nblocks){
+    thread_t *threads;
+    int err;
+    if (nblocks <= 1) {
+        if (nblocks == 1) {
+            blocks[0].ctx->run(&blocks[0]);
+        }
+        return 0;
+    }
+    threads = malloc(nblocks * sizeof(*threads));
+    if (threads == NULL) {
+        return -1;
+    }
+    err = thread_create_batch(threads, (int) nblocks, block_entry, blocks, sizeof(*blocks));
+    if (err == 0) {
+        err = thread_join_many(threads, (int) nblocks, NULL);
+    }
+    free(threads);
+    return err;
+}
+
+static void run_for(struct parallel_block *block){
+    block->ctx->for_body(block->begin, block->end, block->ctx->arg);
+}
+
+static void run_reduce(struct parallel_block *block){
+    block->ctx->reduce_body(block->begin, block->end, block->partial, block->ctx->arg);
+}
+
+/**
+ * Premier passage du préfixe : total du bloc
+ */
+static void run_scan_total(struct parallel_block *block){
+    struct parallel_ctx *ctx = block->ctx;
+    for (size_t i = block->begin; i < block->end; i++) {
+        ctx->combine(block->partial, ctx->data + i * ctx->size, ctx->arg);
+    }
+}
+
+/**
+ * Second passage du préfixe : partial contient le total des blocs précédents
+ */
+static void run_scan_apply(struct parallel_block *block){
+    struct parallel_ctx *ctx = block->ctx;
+    for (size_t i = block->begin; i < block->end; i++) {
+        ctx->combine(block->partial, ctx->data + i * ctx->size, ctx->arg);
+        memcpy(ctx->data + i * ctx->size, block->partial, ctx->size);
+    }
+}
+
+/***************************************
+    Interface Functions Implementation
+****************************************/
+
+/**
+    @fn size_t parallel_grain(size_t n)
+    @brief Taille de bloc adaptée à n indices
+    On vise PARALLEL_BLOCKS_PER_WORKER blocs par worker pour équilibrer la charge,
+    sans descendre sous PARALLEL_GRAIN_MIN pour amortir la création des threads.
+    @return Taille de bloc, au moins 1
+ */
+size_t parallel_grain(size_t n){
+    size_t blocks = (size_t) parallel_workers() * PARALLEL_BLOCKS_PER_WORKER;
+    size_t grain = (n + blocks - 1) / blocks;
+    return grain < PARALLEL_GRAIN_MIN ? PARALLEL_GRAIN_MIN : grain;
+}
+
+/**
+    @fn int parallel_for(size_t begin, size_t end, size_t grain, parallel_for_body_t body, void *arg)
+    @brief Appeler body(b, e, arg) sur des blocs [b, e[ couvrant [begin, end[
+    @param grain Nombre maximal d'indices par bloc, ou PARALLEL_GRAIN_AUTO
+    @return 0 si réussi, -1 en cas d'erreur
+ */
+int parallel_for(size_t begin, size_t end, size_t grain,
+                 parallel_for_body_t body, void *arg){
+    struct parallel_ctx ctx = {.run = run_for, .for_body = body, .arg = arg};
+    struct parallel_block *blocks;
+    size_t nblocks;
+    int err;
+    if (body == NULL) {
+        return -1;
+    }
+    if (end <= begin) {
+        return 0;
+    }
+    blocks = blocks_split(begin, end, grain, &ctx, &nblocks);
+    if (blocks == NULL) {
+        return -1;
+    }
+    err = blocks_run(blocks, nblocks);
+    free(blocks);
+    return err;
+}
+
+/**
+    @fn int parallel_reduce(size_t begin, size_t end, size_t grain, void *result, size_t size, parallel_reduce_body_t body, parallel_combine_t combine, void *arg)
+    @brief Réduire [begin, end[ bloc par bloc, puis combiner les résultats partiels dans l'ordre
+    @param result Elément neutre à l'appel, résultat au retour
+    @param size Taille en octets de result
+    @return 0 si réussi, -1 en cas d'erreur
+ */
+int parallel_reduce(size_t begin, size_t end, size_t grain, void *result, size_t size,
+                    parallel_reduce_body_t body, parallel_combine_t combine, void *arg){
+    struct parallel_ctx ctx = {.run = run_reduce, .reduce_body = body, .combine = combine,
+                               .arg = arg, .size = size, .identity = result};
+    struct parallel_block *blocks;
+    size_t i, nblocks;
+    int err;
+    if (result == NULL || body == NULL || combine == NULL) {
+        return -1;
+    }
+    if (end <= begin) {
+        return 0;
+    }
+    blocks = blocks_split(begin, end, grain, &ctx, &nblocks);
+    if (blocks == NULL) {
+        return -1;
+    }
+    err = blocks_run(blocks, nblocks);
+    if (err == 0) {
+        for (i = 0; i < nblocks; i++) {
+            combine(result, blocks[i].partial, arg);
+        }
+    }
+    free(blocks);
+    return err;
+}
+
+/**
+    @fn int parallel_scan(void *data, size_t n, size_t size, const void *identity, parallel_combine_t combine, void *arg)
+    @brief Préfixe inclusif en place, en deux passages parallèles.
+    Le premier calcule le total de chaque bloc, un préfixe séquentiel de ces totaux donne
+    la valeur de départ de chaque bloc, et le second passage réécrit les éléments.
+    @return 0 si réussi, -1 en cas d'erreur
+ */
+int parallel_scan(void *data, size_t n, size_t size, const void *identity,
+                  parallel_combine_t combine, void *arg){
+    struct parallel_ctx ctx = {.run = run_scan_total, .combine = combine, .arg = arg,
+                               .data = data, .size = size, .identity = identity};
+    struct parallel_block *blocks;
+    size_t i, nblocks;
+    void *carry;
+    int err;
+    if (data == NULL || identity == NULL || combine == NULL) {
+        return -1;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    carry = malloc(2 * size);
+    if (carry == NULL) {
+        return -1;
+    }
+    blocks = blocks_split(0, n, PARALLEL_GRAIN_AUTO, &ctx, &nblocks);
+    if (blocks == NULL) {
+        free(carry);
+        return -1;
+    }
+    err = blocks_run(blocks, nblocks);
+    if (err == 0) {
+        /* le total de chaque bloc est remplacé par la combinaison des blocs qui le précèdent */
+        memcpy(carry, identity, size);
+        for (i = 0; i < nblocks; i++) {
+            memcpy((char *) carry + size, blocks[i].partial, size);
+            memcpy(blocks[i].partial, carry, size);
+            combine(carry, (char *) carry + size, arg);
+        }
+        ctx.run = run_scan_apply;
+        err = blocks_run(blocks, nblocks);
+    }
+    free(blocks);
+    free(carry);
+    return err;
+}
+
+/**
+    @struct sort_range
+    @brief Portion du tableau à trier et tampon de même taille
+*/
+struct sort_range {
+    char *base;
+    char *tmp;
+    size_t n;
+    size_t size;
+    size_t grain;
+    int (*compar)(const void *, const void *);
+};
+
+/**
+ * Tri par insertion d'une petite portion, stable. Le tampon sert à conserver l'élément inséré
+ */
+static void sort_insertion(struct sort_range *range){
+    size_t i, j, size = range->size;
+    for (i = 1; i < range->n; i++) {
+        memcpy(range->tmp, range->base + i * size, size);
+        j = i;
+        while (j > 0 && range->compar(range->base + (j - 1) * size, range->tmp) > 0) {
+            j--;
+        }
+        if (j < i) {
+            memmove(range->base + (j + 1) * size, range->base + j * size, (i - j) * size);
+            memcpy(range->base + j * size, range->tmp, size);
+        }
+    }
+}
+
+/**
+ * Fusionner les deux moitiés triées d'une portion via le tampon, à égalité la gauche d'abord
+ */
+static void sort_merge(struct sort_range *range, size_t mid){
+    size_t size = range->size;
+    char *left = range->base, *left_end = range->base + mid * size;
+    char *right = left_end, *right_end = range->base + range->n * size;
+    char *out = range->tmp;
+    if (range->compar(left_end - size, right) <= 0) {
+        return;
+    }
+    while (left < left_end && right < right_end) {
+        if (range->compar(right, left) < 0) {
+            memcpy(out, right, size);
+            right += size;
+        }
+        else {
+            memcpy(out, left, size);
+            left += size;
+        }
+        out += size;
+    }
+    memcpy(out, left, left_end - left);
+    out += left_end - left;
+    memcpy(out, right, right_end - right);
+    memcpy(range->base, range->tmp, range->n * size);
+}
+
+/**
+ * Trier une portion : les deux moitiés sont lancées avec thread_spawn au-dessus du grain
+ */
+static void *sort_entry(void *arg){
+    struct sort_range *range = arg;
+    struct sort_range halves[2];
+    thread_task_t tasks[2];
+    size_t mid = range->n / 2;
+    int i;
+    if (range->n <= SORT_INSERTION_MAX) {
+        sort_insertion(range);
+        return NULL;
+    }
+    halves[0] = *range;
+    halves[0].n = mid;
+    halves[1] = *range;
+    halves[1].base += mid * range->size;
+    halves[1].tmp += mid * range->size;
+    halves[1].n -= mid;
+    if (range->n > range->grain) {
+        for (i = 0; i < 2; i++) {
+            if (thread_spawn(&tasks[i], sort_entry, &halves[i]) != 0) {
+                sort_entry(&halves[i]);
+                tasks[i].thread = NULL;
+            }
+        }
+        thread_sync(tasks, 2);
+    }
+    else {
+        sort_entry(&halves[0]);
+        sort_entry(&halves[1]);
+    }
+    sort_merge(range, mid);
+    return NULL;
+}
+
+/**
+    @fn int parallel_sort(void *base, size_t n, size_t size, int (*compar)(const void *, const void *))
+    @brief Tri fusion stable : les sous-tris plus grands que le grain sont lancés en parallèle
+    @return 0 si réussi, -1 en cas d'erreur
+ */
+int parallel_sort(void *base, size_t n, size_t size,
+                  int (*compar)(const void *, const void *)){
+    struct sort_range range = {.base = base, .n = n, .size = size, .compar = compar};
+    if (base == NULL || compar == NULL || size == 0) {
+        return -1;
+    }
+    if (n < 2) {
+        return 0;
+    }
+    range.tmp = malloc(n * size);
+    if (range.tmp == NULL) {
+        return -1;
+    }
+    range.grain = parallel_grain(n);
+    sort_entry(&range);
+    free(range.tmp);
+    return 0;
+}
+
+/*******************************
+    Noyaux vectoriels
+********************************/
+
+/**
+    @struct parallel_kernels
+    @brief Noyaux de réduction d'un jeu d'instructions
+*/
+struct parallel_kernels {
+    const char *isa;
+    double (*sum)(const double *data, size_t n);
+    double (*min)(const double *data, size_t n);
+    double (*max)(const double *data, size_t n);
+    double (*dot)(const double *x, const double *y, size_t n);
+    long (*sum_int)(const int *data, size_t n);
+};
+
+static double scalar_sum(const double *data, size_t n){
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static double scalar_min(const double *data, size_t n){
+    double min = INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        min = data[i] < min ? data[i] : min;
+    }
+    return min;
+}
+
+static double scalar_max(const double *data, size_t n){
+    double max = -INFINITY;
+    for (size_t i = 0; i < n; i++) {
+        max = data[i] > max ? data[i] : max;
+    }
+    return max;
+}
+
+static double scalar_dot(const double *x, const double *y, size_t n){
+    double dot = 0;
+    for (size_t i = 0; i < n; i++) {
+        dot += x[i] * y[i];
+    }
+    return dot;
+}
+
+static long scalar_sum_int(const int *data, size_t n){
+    long sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static const struct parallel_kernels scalar_kernels = {
+    "scalar", scalar_sum, scalar_min, scalar_max, scalar_dot, scalar_sum_int
+};
+
+#if defined(__x86_64__)
+/**
+ * SSE2 fait partie de l'ABI x86-64 : ces noyaux sont toujours disponibles.
+ * Deux accumulateurs indépendants masquent la latence des additions.
+ */
+static double sse2_sum(const double *data, size_t n){
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+    return _mm_cvtsd_f64(acc0) + scalar_sum(data + i, n - i);
+}
+
+static double sse2_min(const double *data, size_t n){
+    __m128d acc = _mm_set1_pd(INFINITY);
+    size_t i = 0;
+    double min;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_min_pd(acc, _mm_loadu_pd(data + i));
+    }
+    acc = _mm_min_sd(acc, _mm_unpackhi_pd(acc, acc));
+    min = scalar_min(data + i, n - i);
+    return _mm_cvtsd_f64(acc) < min ? _mm_cvtsd_f64(acc) : min;
+}
+
+static double sse2_max(const double *data, size_t n){
+    __m128d acc = _mm_set1_pd(-INFINITY);
+    size_t i = 0;
+    double max;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_max_pd(acc, _mm_loadu_pd(data + i));
+    }
+    acc = _mm_max_sd(acc, _mm_unpackhi_pd(acc, acc));
+    max = scalar_max(data + i, n - i);
+    return _mm_cvtsd_f64(acc) > max ? _mm_cvtsd_f64(acc) : max;
+}
+
+static double sse2_dot(const double *x, const double *y, size_t n){
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+    return _mm_cvtsd_f64(acc0) + scalar_dot(x + i, y + i, n - i);
+}
+
+static long sse2_sum_int(const int *data, size_t n){
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    long out[2];
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        /* extension de signe sur 64 bits : entrelacement avec le masque de signe */
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    _mm_storeu_si128((__m128i *) out, acc);
+    return out[0] + out[1] + scalar_sum_int(data + i, n - i);
+}
+
+static const struct parallel_kernels sse2_kernels = {
+    "sse2", sse2_sum, sse2_min, sse2_max, sse2_dot, sse2_sum_int
+};
+
+/**
+ * Noyaux AVX2, compilés pour cette cible seulement et choisis à l'exécution
+ */
+__attribute__((target("avx2")))
+static double avx2_hsum(__m256d v){
+    __m128d lo = _mm256_castpd256_pd128(v), hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2")))
+static double avx2_sum(const double *data, size_t n){
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+    }
+    return avx2_hsum(_mm256_add_pd(acc0, acc1)) + scalar_sum(data + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double avx2_min(const double *data, size_t n){
+    __m256d acc = _mm256_set1_pd(INFINITY);
+    __m128d half;
+    size_t i = 0;
+    double min;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_min_pd(acc, _mm256_loadu_pd(data + i));
+    }
+    half = _mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    half = _mm_min_sd(half, _mm_unpackhi_pd(half, half));
+    min = scalar_min(data + i, n - i);
+    return _mm_cvtsd_f64(half) < min ? _mm_cvtsd_f64(half) : min;
+}
+
+__attribute__((target("avx2")))
+static double avx2_max(const double *data, size_t n){
+    __m256d acc = _mm256_set1_pd(-INFINITY);
+    __m128d half;
+    size_t i = 0;
+    double max;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_max_pd(acc, _mm256_loadu_pd(data + i));
+    }
+    half = _mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    half = _mm_max_sd(half, _mm_unpackhi_pd(half, half));
+    max = scalar_max(data + i, n - i);
+    return _mm_cvtsd_f64(half) > max ? _mm_cvtsd_f64(half) : max;
+}
+
+__attribute__((target("avx2")))
+static double avx2_dot(const double *x, const double *y, size_t n){
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+    }
+    return avx2_hsum(_mm256_add_pd(acc0, acc1)) + scalar_dot(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static long avx2_sum_int(const int *data, size_t n){
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    long out[4];
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *) (data + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *) (data + i + 4))));
+    }
+    _mm256_storeu_si256((__m256i *) out, _mm256_add_epi64(acc0, acc1));
+    return out[0] + out[1] + out[2] + out[3] + scalar_sum_int(data + i, n - i);
+}
+
+static const struct parallel_kernels avx2_kernels = {
+    "avx2", avx2_sum, avx2_min, avx2_max, avx2_dot, avx2_sum_int
+};
+#endif
+
+static const struct parallel_kernels *kernels = NULL;
+
+/**
+ * Noyaux du meilleur jeu d'instructions disponible, détecté au premier appel
+ */
+static const struct parallel_kernels *kernels_get(void){
+    if (kernels == NULL) {
+        #if defined(__x86_64__)
+        __builtin_cpu_init();
+        kernels = __builtin_cpu_supports("avx2") ? &avx2_kernels : &sse2_kernels;
+        #else
+        kernels = &scalar_kernels;
+        #endif
+    }
+    return kernels;
+}
+
+/**
+    @fn const char *parallel_kernel_isa(void)
+    @brief Nom du jeu d'instructions utilisé par les noyaux de réduction
+ */
+const char *parallel_kernel_isa(void){
+    return kernels_get()->isa;
+}
+
+/**
+    @fn int parallel_kernel_select(const char *isa)
+    @brief Forcer les noyaux d'un jeu d'instructions, NULL pour revenir à la détection
+    @return 0 si réussi, -1 si le jeu d'instructions est inconnu ou non supporté
+ */
+int parallel_kernel_select(const char *isa){
+    if (isa == NULL) {
+        kernels = NULL;
+        kernels_get();
+        return 0;
+    }
+    if (strcmp(isa, "scalar") == 0) {
+        kernels = &scalar_kernels;
+        return 0;
+    }
+    #if defined(__x86_64__)
+    if (strcmp(isa, "sse2") == 0) {
+        kernels = &sse2_kernels;
+        return 0;
+    }
+    if (strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        kernels = &avx2_kernels;
+        return 0;
+    }
+    #endif
+    return -1;
+}
+
+/**
+    @struct kernel_arg
+    @brief Tableaux réduits par un noyau
+*/
+struct kernel_arg {
+    const struct parallel_kernels *kernels;
+    const void *x;
+    const double *y;
+};
+
+static void kernel_sum_body(size_t begin, size_t end, void *partial, void *arg){
+    struct kernel_arg *k = arg;
+    *(double *) partial += k->kernels->sum((const double *) k->x + begin, end - begin);
+}
+
+static void kernel_min_body(size_t begin, size_t end, void *partial, void *arg){
+    struct kernel_arg *k = arg;
+    double min = k->kernels->min((const double *) k->x + begin, end - begin);
+    *(double *) partial = min < *(double *) partial ? min : *(double *) partial;
+}
+
+static void kernel_max_body(size_t begin, size_t end, void *partial, void *arg){
+    struct kernel_arg *k = arg;
+    double max = k->kernels->max((const double *) k->x + begin, end - begin);
+    *(double *) partial = max > *(double *) partial ? max : *(double *) partial;
+}
+
+static void kernel_dot_body(size_t begin, size_t end, void *partial, void *arg){
+    struct kernel_arg *k = arg;
+    *(double *) partial += k->kernels->dot((const double *) k->x + begin, k->y + begin, end - begin);
+}
+
+static void kernel_sum_int_body(size_t begin, size_t end, void *partial, void *arg){
+    struct kernel_arg *k = arg;
+    *(long *) partial += k->kernels->sum_int((const int *) k->x + begin, end - begin);
+}
+
+static void combine_sum(void *into, const void *from, void *arg __attribute__((unused))){
+    *(double *) into += *(const double *) from;
+}
+
+static void combine_min(void *into, const void *from, void *arg __attribute__((unused))){
+    if (*(const double *) from < *(double *) into) {
+        *(double *) into = *(const double *) from;
+    }
+}
+
+static void combine_max(void *into, const void *from, void *arg __attribute__((unused))){
+    if (*(const double *) from > *(double *) into) {
+        *(double *) into = *(const double *) from;
+    }
+}
+
+static void combine_sum_int(void *into, const void *from, void *arg __attribute__((unused))){
+    *(long *) into += *(const long *) from;
+}
+
+/**
+ * Taille de bloc des réductions vectorielles : un multiple de PARALLEL_KERNEL_BLOCK octets
+ */
+static size_t kernel_grain(size_t n, size_t elem_size){
+    size_t block = PARALLEL_KERNEL_BLOCK / elem_size;
+    return (parallel_grain(n) + block - 1) / block * block;
+}
+
+/**
+    @fn double parallel_sum(const double *data, size_t n)
+    @brief Somme des n éléments de data
+ */
+double parallel_sum(const double *data, size_t n){
+    struct kernel_arg arg = {kernels_get(), data, NULL};
+    double sum = 0;
+    if (parallel_reduce(0, n, kernel_grain(n, sizeof(*data)), &sum, sizeof(sum),
+                        kernel_sum_body, combine_sum, &arg) != 0) {
+        sum = arg.kernels->sum(data, n);
+    }
+    return sum;
+}
+
+/**
+    @fn double parallel_min(const double *data, size_t n)
+    @brief Plus petit des n éléments de data, +INFINITY si n est nul
+ */
+double parallel_min(const double *data, size_t n){
+    struct kernel_arg arg = {kernels_get(), data, NULL};
+    double min = INFINITY;
+    if (parallel_reduce(0, n, kernel_grain(n, sizeof(*data)), &min, sizeof(min),
+                        kernel_min_body, combine_min, &arg) != 0) {
+        min = arg.kernels->min(data, n);
+    }
+    return min;
+}
+
+/**
+    @fn double parallel_max(const double *data, size_t n)
+    @brief Plus grand des n éléments de data, -INFINITY si n est nul
+ */
+double parallel_max(const double *data, size_t n){
+    struct kernel_arg arg = {kernels_get(), data, NULL};
+    double max = -INFINITY;
+    if (parallel_reduce(0, n, kernel_grain(n, sizeof(*data)), &max, sizeof(max),
+                        kernel_max_body, combine_max, &arg) != 0) {
+        max = arg.kernels->max(data, n);
+    }
+    return max;
+}
+
+/**
+    @fn double parallel_dot(const double *x, const double *y, size_t n)
+    @brief Produit scalaire des n premiers éléments de x et y
+ */
+double parallel_dot(const double *x, const double *y, size_t n){
+    struct kernel_arg arg = {kernels_get(), x, y};
+    double dot = 0;
+    if (parallel_reduce(0, n, kernel_grain(n, sizeof(*x)), &dot, sizeof(dot),
+                        kernel_dot_body, combine_sum, &arg) != 0) {
+        dot = arg.kernels->dot(x, y, n);
+    }
+    return dot;
+}
+
+/**
+    @fn long parallel_sum_int(const int *data, size_t n)
+    @brief Somme des n entiers de data, accumulée sur 64 bits
+ */
+long parallel_sum_int(const int *data, size_t n){
+    struct kernel_arg arg = {kernels_get(), data, NULL};
+    long sum = 0;
+    if (parallel_reduce(0, n, kernel_grain(n, sizeof(*data)), &sum, sizeof(sum),
+                        kernel_sum_int_body, combine_sum_int, &arg) != 0) {
+        sum = arg.kernels->sum_int(data, n);
+    }
+    return sum;
+}
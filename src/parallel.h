@@ -0,0 +1,73 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <stddef.h>
+
+/* Algorithmes parallèles construits sur la bibliothèque de threads.
+ *
+ * L'intervalle [begin, end[ est découpé en blocs d'au plus `grain` indices,
+ * chaque bloc étant traité par un thread. Avec grain = PARALLEL_GRAIN_AUTO,
+ * la taille des blocs est choisie d'après le nombre de workers : assez de
+ * blocs pour les occuper tous, sans descendre sous PARALLEL_GRAIN_MIN.
+ * Les fonctions renvoient 0 en cas de succès, -1 en cas d'erreur.
+ */
+#define PARALLEL_GRAIN_AUTO 0
+#define PARALLEL_GRAIN_MIN 4096
+
+/* traite les indices [begin, end[ */
+typedef void (*parallel_for_body_t)(size_t begin, size_t end, void *arg);
+
+/* accumule les indices [begin, end[ dans partial, initialisé à l'élément neutre */
+typedef void (*parallel_reduce_body_t)(size_t begin, size_t end, void *partial, void *arg);
+
+/* combine deux valeurs : into = into op from (op doit être associative) */
+typedef void (*parallel_combine_t)(void *into, const void *from, void *arg);
+
+/* taille de bloc choisie pour n indices avec PARALLEL_GRAIN_AUTO */
+size_t parallel_grain(size_t n);
+
+/* appeler body sur des blocs de [begin, end[, en parallèle */
+int parallel_for(size_t begin, size_t end, size_t grain,
+                 parallel_for_body_t body, void *arg);
+
+/* réduire [begin, end[ : result contient l'élément neutre à l'appel (valeur de
+ * `size` octets) et reçoit la combinaison, dans l'ordre, des résultats des blocs.
+ */
+int parallel_reduce(size_t begin, size_t end, size_t grain, void *result, size_t size,
+                    parallel_reduce_body_t body, parallel_combine_t combine, void *arg);
+
+/* préfixe inclusif en place des n éléments de `size` octets de data :
+ * data[i] = data[0] op ... op data[i]. identity est l'élément neutre de op.
+ */
+int parallel_scan(void *data, size_t n, size_t size, const void *identity,
+                  parallel_combine_t combine, void *arg);
+
+/* tri fusion des n éléments de `size` octets de base, stable, selon compar */
+int parallel_sort(void *base, size_t n, size_t size,
+                  int (*compar)(const void *, const void *));
+
+/* Réductions usuelles sur des tableaux : chaque bloc est traité par un
+ * noyau vectoriel (AVX2 ou SSE2 selon le processeur, détecté à l'exécution),
+ * et la taille des blocs est un multiple de PARALLEL_KERNEL_BLOCK octets.
+ * Le résultat des sommes flottantes peut différer d'une somme séquentielle
+ * par l'ordre des additions. Si les blocs ne peuvent pas être lancés
+ * (allocation ou création de thread impossible), le noyau parcourt [0, n[
+ * séquentiellement : le résultat reste exact.
+ */
+#define PARALLEL_KERNEL_BLOCK (32*1024)
+
+double parallel_sum(const double *data, size_t n);
+double parallel_min(const double *data, size_t n);   /* +INFINITY si n = 0 */
+double parallel_max(const double *data, size_t n);   /* -INFINITY si n = 0 */
+double parallel_dot(const double *x, const double *y, size_t n);
+long parallel_sum_int(const int *data, size_t n);
+
+/* jeu d'instructions utilisé par les noyaux : "avx2", "sse2" ou "scalar" */
+const char *parallel_kernel_isa(void);
+
+/* forcer un jeu d'instructions (NULL pour revenir à la détection).
+ * renvoie 0 en cas de succès, -1 s'il n'est pas disponible.
+ */
+int parallel_kernel_select(const char *isa);
+
+#endif /* __PARALLEL_H__ */
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "thread.h"
 #include <ucontext.h>
 #include <stdio.h>
@@ -6,21 +7,62 @@
 #include <valgrind/valgrind.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <time.h>
 #include <errno.h>
 #include <stdatomic.h>
 #include <assert.h>
 #include <unistd.h>
 #include <sys/mman.h>
-
-#define CONTEXT_STACK_SIZE 32*1024
+#include <stdint.h>
+#include <string.h>
+#include <dlfcn.h>
+
+#define CONTEXT_STACK_SIZE 1024*1024
+#define STACK_WATERMARK 32*1024
+#define SCHED_STACK_SIZE 1024*1024
+#define SHARED_STACK_SIZE 1024*1024
+#define SIGNAL_STACK_SIZE 64*1024
+#define CONTEXT_SP_MARGIN 1024
+#define STACK_PAINT 0xa5a5a5a5a5a5a5a5UL
+#define STACK_PROFILE_BUCKETS 64
+#define LOCK_PROFILE_BUCKETS 64
+#define WAIT_BUCKETS 64
+#define THREAD_KEY_INLINE 8
+#define AUTOTUNE_MIN_SAMPLES 8
+#define AUTOTUNE_SLACK 8*1024
+#define STACK_CLASS_MIN_SHIFT 12
+#define NB_STACK_CLASSES 12
+#define STACK_POOL_MAX 4096
+#define DESCRIPTOR_POOL_MAX 4096
+#define SPAWN_HEADROOM 64*1024
+#define MUTEX_WAITERS 1UL
+#define MUTEX_SPIN_MIN 16
+#define MUTEX_SPIN_MAX 1000
+#define WORKER_SLOT 0
 #define MAX_PRIORITY 10
 #define MIN_PRIORITY 0
 #define TIMESLICE 10
+#define SCHED_SCORE_MAX 8
+#define SCHED_SCORE_CLASS 2
+#define PREEMPT_CLOCK CLOCK_THREAD_CPUTIME_ID
 #define UNITARY_QUANTUM 100
 #define MAX_SIGNALS 10
 #define NBR_SIGNALS 3
 #define PAGE_SIZE 4096
+#define CACHE_LINE_SIZE 64
+
+#ifdef STACKOVERFLOW
+#define STACK_GUARD_SIZE PAGE_SIZE
+#else
+#define STACK_GUARD_SIZE 0
+#endif
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#define STACK_CLASS_SIZE(class) ((size_t)1 << ((class) + STACK_CLASS_MIN_SHIFT))
+#define DESCRIPTOR_SIZE (sizeof(struct thread)+sizeof(thread_signal_t))
+#define MUTEX_OWNER(word) ((struct thread *) ((word) & ~MUTEX_WAITERS))
 
 /**********************   
     Global Variables 
@@ -28,7 +70,11 @@
 thread_t current_thread = NULL;
 int number_thread = 0;
 struct thread *main_thread = NULL;
-struct itimerval timer,remainingtime;
+unsigned long timeslice = TIMESLICE * 1000;
+int sched_adaptive = 1;
+volatile int thread_resched = 0;
+int nb_ready = 0;
+thread_sched_stats_t sched_stats = {0};
 struct sigaction act_timer;
 signal_t signals[NBR_SIGNALS] = {
     {.type = SIG_USER1, .handler = default_signal_handler, .old_handler = default_signal_handler},
@@ -36,6 +82,75 @@ signal_t signals[NBR_SIGNALS] = {
     {.type = SIG_KILL, .handler = default_signal_handler, .old_handler = default_signal_handler}
 };
 signal_t no_signal = {.type = Error, .handler = NULL};
+thread_mem_stats_t mem_stats = {0};
+char *main_stack_low = NULL;
+
+/**
+    @struct stack_pool
+    @brief Réserve de piles libres d'une classe de taille.
+    Les piles libres sont chaînées par leur dernier mot (en haut de pile, dans la partie
+    conservée en mémoire), sans allocation supplémentaire.
+*/
+struct stack_pool {
+    void *free;     /*!<Première pile libre*/
+    int count;      /*!<Nombre de piles dans la réserve*/
+};
+struct stack_pool stack_pools[NB_STACK_CLASSES];
+size_t stack_watermark = STACK_WATERMARK;
+
+/**
+ * Réserve de descripteurs libres, chaînés par leur lien threads (structure de signaux conservée)
+ */
+struct thread *descriptor_pool = NULL;
+int descriptor_pool_count = 0;
+
+/**
+    @struct stack_profile_entry
+    @brief Plus hautes marques de pile observées pour une fonction d'entrée de thread.
+    L'histogramme compte, pour chaque classe de taille, les threads dont la plus haute
+    marque tenait dans cette classe.
+*/
+struct stack_profile_entry {
+    void *(*func)(void *);
+    unsigned long samples;
+    size_t max;
+    size_t total;
+    unsigned long histogram[NB_STACK_CLASSES];
+    struct stack_profile_entry *next;
+};
+struct stack_profile_entry *stack_profiles[STACK_PROFILE_BUCKETS];
+int stack_profiling = 0;
+int stack_autotune = 0;
+
+/**
+ * Statistiques de contention des mutex, par site d'initialisation
+ */
+struct lock_profile_entry {
+    thread_lock_profile_t stats;
+    struct lock_profile_entry *next;
+};
+struct lock_profile_entry *lock_profiles[LOCK_PROFILE_BUCKETS];
+int lock_profiling = 0;
+
+/**
+ * Files d'attente de thread_wait_on(), chaînées par wait_next et réparties par adresse
+ */
+struct thread *wait_table[WAIT_BUCKETS];
+
+/**
+ * Clés de données propres aux threads ; les indices ne sont jamais réutilisés
+ */
+struct thread_key_entry {
+    void (*destructor)(void *);
+    int used;
+};
+struct thread_key_entry thread_keys[THREAD_KEYS_MAX];
+unsigned int nb_keys = 0;
+
+/**
+ * Liste de threads hors de la file des threads prêts (création par lot)
+ */
+TAILQ_HEAD(threadlist, thread);
 
 #ifdef FIFO
 TAILQ_HEAD(threadqueue, thread) ready;
@@ -50,25 +165,315 @@ struct threadqueue ready[MAX_PRIORITY];
 #endif
 
 
+/**
+    @struct thread_context
+    @brief Contexte sauvegardé lors d'un changement de thread.
+    Sur x86-64, on ne conserve que ce que l'ABI System V impose de préserver à travers
+    un appel de fonction : les registres callee-saved, le pointeur de pile, l'adresse de reprise
+    et les mots de contrôle MXCSR et x87. Le masque de signaux n'est pas sauvegardé.
+    Sur les autres architectures, on se replie sur un ucontext_t.
+*/
+#if defined(__x86_64__)
+struct thread_context {
+    void *rsp;          /*!<Pointeur de pile à la reprise (offset 0)*/
+    void *rbp;          /*!<offset 8*/
+    void *rbx;          /*!<offset 16*/
+    void *r12;          /*!<offset 24, fonction du thread au premier lancement*/
+    void *r13;          /*!<offset 32, argument du thread au premier lancement*/
+    void *r14;          /*!<offset 40*/
+    void *r15;          /*!<offset 48*/
+    void *rip;          /*!<Adresse de reprise (offset 56)*/
+    uint32_t mxcsr;     /*!<Contrôle et état SSE (offset 64)*/
+    uint16_t fpucw;     /*!<Mot de contrôle x87 (offset 68)*/
+};
+#else
+struct thread_context {
+    ucontext_t uc;
+    void *sp;           /*!<Bas de la partie vivante de la pile, noté au changement de contexte*/
+};
+#endif
+
+/**
+    @enum thread_state
+    @brief Etat d'un thread vis-à-vis de l'ordonnanceur.
+*/
+enum thread_state {
+    THREAD_READY = 0,   /*!<Dans la file des threads prêts (y compris le thread courant)*/
+    THREAD_BLOCKED,     /*!<Retiré de la file en attente d'un évènement (join, condition)*/
+    THREAD_DONE         /*!<Terminé, en attente d'être joint*/
+};
+
 /**
     @struct struct thread
     @brief Structure représentant nos threads.
     Cette structure contient les informations nécessaires pour représenter un thread, telles que son identifiant,
     son contexte, son résultat de retour, son état d'exécution, etc.
+    Les champs lus lors des parcours de la file des threads prêts sont regroupés en tête,
+    dans la première ligne de cache ; la structure est alignée sur une ligne de cache.
 */
 struct thread{
-    int id; 
-    ucontext_t uc; 
-    void *retval;
-    int is_done;
-    struct thread *joiner;
     TAILQ_ENTRY(thread) threads;
-    int valgrind_stackid;
-    int is_locked;
-    int id_first;
+    int state;
     int priority;
+    int id;
+    struct thread *joiner;
+    struct thread_context ctx;
+    void *retval;
+    int id_first;
+    int valgrind_stackid;
+    void *stack;
+    size_t stack_size;
+    int stack_class;            /*!<Classe de taille de la pile, -1 en mode pile partagée*/
+    void *saved_stack;          /*!<Mode pile partagée : copie de la partie vivante de la pile*/
+    size_t saved_size;
+    size_t saved_capacity;
+    void *(*func)(void *);      /*!<Fonction d'entrée, clé du profilage des piles*/
+    int painted;                /*!<Pile peinte pour la mesure de sa plus haute marque*/
+    int detached;               /*!<Ressources libérées dès la fin du thread, sans join*/
+    unsigned long timeslice;    /*!<Tranche de temps propre au thread en µs, 0 pour celle par défaut*/
+    int preempt_count;          /*!<Profondeur de sections critiques à restaurer à la reprise du thread*/
+    int sched_score;            /*!<Passages de main volontaires moins préemptions, borné à ±SCHED_SCORE_MAX*/
+    int join_pending;           /*!<Nombre de terminaisons attendues avant de réveiller ce thread*/
+    struct thread *join_first;  /*!<Premier thread terminé parmi ceux attendus*/
+    struct thread *scope_next;  /*!<Thread suivant de la même portée*/
+    struct thread *wait_next;   /*!<Thread suivant dans la file d'attente d'un mutex*/
+    thread_mutex_t *wait_mutex; /*!<Mutex attendu, pour propager l'héritage de priorité*/
+    int mutex_held;             /*!<Nombre de mutex détenus*/
+    int base_priority;          /*!<Priorité avant héritage, -1 si aucune priorité n'est héritée*/
+    int boost_priority;         /*!<Priorité avant le coup de pouce d'un réveil, -1 si aucun*/
+    int wait_writer;            /*!<En attente d'un verrou lecteurs-rédacteurs en tant que rédacteur*/
+    const volatile int *wait_addr; /*!<Adresse attendue dans thread_wait_on()*/
+    void **specific;            /*!<Valeurs des clés, specific_inline tant qu'elles y tiennent*/
+    unsigned int specific_size; /*!<Nombre de cases de specific*/
+    void *specific_inline[THREAD_KEY_INLINE]; /*!<Premières cases, dans le descripteur*/
     thread_signal_t *th;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/**
+    @struct thread_job
+    @brief Tâche sans pile, exécutée jusqu'au bout sur la pile de l'ordonnanceur
+*/
+struct thread_job {
+    void *(*func)(void *);
+    void *arg;
+    void *retval;
+    int done;
+    STAILQ_ENTRY(thread_job) next;
+};
+
+/**
+    @struct worker
+    @brief Etat du worker (thread noyau) qui exécute les threads.
+    La bibliothèque n'utilise pour l'instant qu'un seul worker.
+*/
+struct worker {
+    void *sched_stack;              /*!<Pile de l'ordonnanceur, pour les changements de contexte qui doivent quitter la pile du thread sortant*/
+    STAILQ_HEAD(, thread_job) tasks;   /*!<Tâches sans pile en attente d'exécution*/
+    volatile int preempt_count;     /*!<Profondeur des sections critiques en cours : préemption interdite si non nulle*/
+    volatile int preempt_pending;   /*!<Tick reçu en section critique, honoré à la sortie de la dernière*/
+    int preempting;                 /*!<Le changement de contexte en cours est une préemption*/
+    int preempt_mode;               /*!<THREAD_PREEMPT_SIGNAL ou THREAD_PREEMPT_COOPERATIVE*/
+    timer_t timer;                  /*!<Timer POSIX de préemption, propre au worker*/
+    unsigned long timer_slice;      /*!<Période programmée en µs, 0 si le timer est désarmé*/
+    void *shared_stack;             /*!<Pile sur laquelle s'exécutent les threads en mode pile partagée*/
+    struct thread *shared_owner;    /*!<Thread dont les trames occupent actuellement la pile partagée*/
+    struct thread *dead;            /*!<Thread détaché terminé, à libérer une fois sa pile quittée*/
 };
+struct worker worker;
+
+/**********************
+    Internal Functions
+***********************/
+static void *stack_pop(int class);
+static void stack_release(void *stack, int class);
+static void thread_free(struct thread *thread);
+static void stack_paint(struct thread *thread);
+static void stack_profile_record(struct thread *thread);
+static void thread_key_destroy_values(struct thread *thread);
+static size_t stack_autotune_size(void *(*func)(void *));
+static int stack_class(size_t size);
+static const thread_attr_t *attr_autotune(const thread_attr_t *attr, thread_attr_t *tuned,
+                                          void *(*func)(void *));
+static void thread_prepare(struct thread *thread, void *(*func)(void *), void *funcarg);
+static void stack_push(void *stack, int class);
+static void add_threads_to_queue_tail(struct threadlist *list, int count);
+static void preempt_timer_update(struct thread *next);
+static int preempt_timer_create(int mode, timer_t *timer);
+static unsigned long thread_slice(struct thread *thread);
+static void sched_account(struct thread *thread);
+static void thread_unpark(struct thread *thread);
+static struct thread **mutex_next_waiter(thread_mutex_t *mutex);
+static int mutex_spin(thread_mutex_t *mutex, struct thread *self);
+static int thread_on_cpu(struct thread *thread);
+static unsigned long lock_profile_now(void);
+static thread_lock_profile_t *lock_profile_lookup(void *site, int create);
+static void lock_profile_acquired(thread_mutex_t *mutex, unsigned long start);
+static void mutex_inherit(struct thread *owner, int priority);
+static void thread_set_effective_priority(struct thread *thread, int priority);
+static void thread_park(struct thread *self);
+static unsigned long rwlock_readers(thread_rwlock_t *rwlock);
+static void rwlock_wait(thread_rwlock_t *rwlock, struct thread *self, int writer);
+static void rwlock_grant(thread_rwlock_t *rwlock);
+static struct thread **wait_bucket(const volatile int *addr);
+#ifdef PREEMPTION
+static void preempt(void);
+#endif
+static void stack_reserve(int class, int count);
+static void join_wait(struct thread *self, int count);
+static int join_handoff(struct thread *self, struct thread *joiner);
+static size_t stack_headroom(void);
+static void tasks_run(void);
+static struct thread_context *sched_hook(void *arg);
+static void main_stack_init(void);
+static int join_check(thread_t *threads, int n);
+
+/**********************
+    Context Switch
+***********************/
+
+#if defined(__x86_64__)
+/**
+ * Sauvegarder le contexte courant dans from et reprendre celui de to.
+ * L'adresse de retour est dépilée et conservée dans rip : reprendre un contexte
+ * revient à restaurer la pile et à sauter à cette adresse.
+ */
+void context_switch(struct thread_context *from, struct thread_context *to);
+
+/**
+ * Sauvegarder le contexte courant dans from, puis appeler hook(arg) sur la pile stack_top
+ * et reprendre le contexte qu'il renvoie. Le hook s'exécute hors de la pile du thread
+ * sortant et du thread entrant : il peut les copier, les libérer ou les réécrire.
+ */
+void context_switch_call(struct thread_context *from, struct thread_context *(*hook)(void *),
+                         void *arg, void *stack_top);
+
+/**
+ * Point d'entrée d'un nouveau contexte : appelle call_function(r12, r13).
+ */
+void context_entry(void);
+
+__asm__(
+    ".text\n"
+    ".globl context_switch\n"
+    ".hidden context_switch\n"
+    ".type context_switch, @function\n"
+    ".p2align 4\n"
+    "context_switch:\n"
+    "    movq (%rsp), %rax\n"
+    "    leaq 8(%rsp), %rcx\n"
+    "    movq %rcx, 0(%rdi)\n"
+    "    movq %rbp, 8(%rdi)\n"
+    "    movq %rbx, 16(%rdi)\n"
+    "    movq %r12, 24(%rdi)\n"
+    "    movq %r13, 32(%rdi)\n"
+    "    movq %r14, 40(%rdi)\n"
+    "    movq %r15, 48(%rdi)\n"
+    "    movq %rax, 56(%rdi)\n"
+    "    stmxcsr 64(%rdi)\n"
+    "    fnstcw 68(%rdi)\n"
+    "context_restore:\n"
+    "    movq 0(%rsi), %rsp\n"
+    "    movq 8(%rsi), %rbp\n"
+    "    movq 16(%rsi), %rbx\n"
+    "    movq 24(%rsi), %r12\n"
+    "    movq 32(%rsi), %r13\n"
+    "    movq 40(%rsi), %r14\n"
+    "    movq 48(%rsi), %r15\n"
+    "    ldmxcsr 64(%rsi)\n"
+    "    fldcw 68(%rsi)\n"
+    "    jmpq *56(%rsi)\n"
+    ".size context_switch, .-context_switch\n"
+    ".globl context_switch_call\n"
+    ".hidden context_switch_call\n"
+    ".type context_switch_call, @function\n"
+    ".p2align 4\n"
+    "context_switch_call:\n"
+    "    movq (%rsp), %rax\n"
+    "    leaq 8(%rsp), %r8\n"
+    "    movq %r8, 0(%rdi)\n"
+    "    movq %rbp, 8(%rdi)\n"
+    "    movq %rbx, 16(%rdi)\n"
+    "    movq %r12, 24(%rdi)\n"
+    "    movq %r13, 32(%rdi)\n"
+    "    movq %r14, 40(%rdi)\n"
+    "    movq %r15, 48(%rdi)\n"
+    "    movq %rax, 56(%rdi)\n"
+    "    stmxcsr 64(%rdi)\n"
+    "    fnstcw 68(%rdi)\n"
+    "    movq %rcx, %rsp\n"
+    "    movq %rdx, %rdi\n"
+    "    call *%rsi\n"
+    "    movq %rax, %rsi\n"
+    "    jmp context_restore\n"
+    ".size context_switch_call, .-context_switch_call\n"
+    ".globl context_entry\n"
+    ".hidden context_entry\n"
+    ".type context_entry, @function\n"
+    ".p2align 4\n"
+    "context_entry:\n"
+    "    movq %r12, %rdi\n"
+    "    movq %r13, %rsi\n"
+    "    call call_function@PLT\n"
+    "    ud2\n"
+    ".size context_entry, .-context_entry\n"
+);
+
+/**
+ * Préparer un contexte qui exécutera call_function(func, funcarg) sur la pile donnée.
+ */
+static void context_make(struct thread_context *ctx, void *stack, size_t size,
+                         void *(*func)(void *), void *funcarg){
+    /* la pile doit être alignée sur 16 octets au moment du call de context_entry */
+    ctx->rsp = (void *)(((uintptr_t)stack + size) & ~(uintptr_t)15);
+    ctx->rbp = NULL;
+    ctx->r12 = (void *)func;
+    ctx->r13 = funcarg;
+    ctx->rip = (void *)context_entry;
+    __asm__ volatile ("stmxcsr %0" : "=m" (ctx->mxcsr));
+    __asm__ volatile ("fnstcw %0" : "=m" (ctx->fpucw));
+}
+#else
+/**
+ * ucontext_t n'expose pas le pointeur de pile de façon portable : on note celui de l'appelant
+ * de swapcontext(), avec une marge pour les trames de swapcontext() et la zone rouge
+ */
+static void context_switch(struct thread_context *from, struct thread_context *to){
+    from->sp = (char *) __builtin_frame_address(0) - CONTEXT_SP_MARGIN;
+    swapcontext(&from->uc, &to->uc);
+}
+
+static ucontext_t hook_uc;
+static struct thread_context *(*pending_hook)(void *);
+static void *pending_arg;
+
+static void context_hook_entry(void){
+    struct thread_context *to = pending_hook(pending_arg);
+    setcontext(&to->uc);
+}
+
+static void context_switch_call(struct thread_context *from, struct thread_context *(*hook)(void *),
+                                void *arg, void *stack_top){
+    (void) stack_top;
+    getcontext(&hook_uc);
+    hook_uc.uc_stack.ss_sp = worker.sched_stack;
+    hook_uc.uc_stack.ss_size = SCHED_STACK_SIZE;
+    hook_uc.uc_link = NULL;
+    makecontext(&hook_uc, context_hook_entry, 0);
+    pending_hook = hook;
+    pending_arg = arg;
+    from->sp = (char *) __builtin_frame_address(0) - CONTEXT_SP_MARGIN;
+    swapcontext(&from->uc, &hook_uc);
+}
+
+static void context_make(struct thread_context *ctx, void *stack, size_t size,
+                         void *(*func)(void *), void *funcarg){
+    getcontext(&ctx->uc);
+    ctx->uc.uc_stack.ss_sp = stack;
+    ctx->uc.uc_stack.ss_size = size;
+    ctx->uc.uc_link = NULL;
+    makecontext(&ctx->uc, (void (*)(void))call_function, 2, func, funcarg);
+}
+#endif
 
 
 /*************************************** 
@@ -84,6 +489,15 @@ extern thread_t thread_self(void){
     return current_thread;
 }
 
+/**
+    @fn int thread_get_priority(thread_t thread)
+    @brief Priorité effective d'un thread, priorité héritée d'un thread en attente comprise
+    @return La priorité, -1 si thread est NULL
+*/
+int thread_get_priority(thread_t thread){
+    return thread != NULL ? thread->priority : -1;
+}
+
 
 /**
     @fn extern int thread_create(thread_t *newthread, void *(*func)(void *), void *funcarg)
@@ -96,14 +510,109 @@ extern thread_t thread_self(void){
 */
 
 extern int thread_create(thread_t *newthread, void *(*func)(void *), void *funcarg){
-    *newthread = thread_init();
-    // printf("newthread %p, stack %p\n", *newthread, (*newthread)->uc.uc_stack.ss_sp);
-    makecontext(&(*newthread)->uc,(void (*)(void))call_function, 2, func, funcarg);
+    return thread_create_attr(newthread, NULL, func, funcarg);
+}
+
+/**
+    @fn extern int thread_create_attr(thread_t *newthread, const thread_attr_t *attr, void *(*func)(void *), void *funcarg)
+    @brief Créer un nouveau thread avec les attributs donnés.
+    @param newthread Pointeur vers la variable qui recevra l'identifiant du nouveau thread.
+    @param attr Attributs du thread, ou NULL pour les valeurs par défaut.
+    @param func Pointeur vers la fonction que le thread exécutera.
+    @param funcarg Pointeur vers l'argument que le thread passera à la fonction.
+    @return 0 si la création du thread a réussi, -1 en cas d'erreur.
+*/
+extern int thread_create_attr(thread_t *newthread, const thread_attr_t *attr, void *(*func)(void *), void *funcarg){
+    thread_attr_t tuned;
+    attr = attr_autotune(attr, &tuned, func);
+    disable_interrupt();
+    *newthread = thread_init(attr);
+    if (*newthread == NULL) {
+        enable_interrupt();
+        return -1;
+    }
+    thread_prepare(*newthread, func, funcarg);
     add_thread_to_queue_tail(*newthread);
     number_thread++;
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn extern int thread_create_batch(thread_t *out, int n, void *(*func)(void *), void *args, size_t stride)
+    @brief Créer n threads exécutant la même fonction en un seul appel.
+    Les piles manquantes sont réservées en bloc, les contextes sont préparés hors de la file,
+    puis tous les threads sont ajoutés à la file des threads prêts en une seule opération.
+    Le thread i reçoit l'argument args + i * stride (stride nul : tous reçoivent args).
+    @param out Tableau recevant les identifiants des n threads
+    @param n Nombre de threads à créer
+    @param func Fonction exécutée par les threads
+    @param args Argument du premier thread
+    @param stride Écart en octets entre les arguments de deux threads consécutifs
+    @return 0 si tous les threads ont été créés, -1 sinon (aucun thread n'est alors créé)
+*/
+extern int thread_create_batch(thread_t *out, int n, void *(*func)(void *), void *args, size_t stride){
+    struct threadlist batch;
+    thread_attr_t tuned;
+    const thread_attr_t *attr;
+    int i;
+    if (out == NULL || n < 0) {
+        return -1;
+    }
+    attr = attr_autotune(NULL, &tuned, func);
+    disable_interrupt();
+    stack_reserve(stack_class(attr ? attr->stack_size : 0), n);
+    TAILQ_INIT(&batch);
+    for (i = 0; i < n; i++) {
+        out[i] = thread_init(attr);
+        if (out[i] == NULL) {
+            number_thread -= i;
+            while (--i >= 0) {
+                thread_free(out[i]);
+            }
+            enable_interrupt();
+            return -1;
+        }
+        thread_prepare(out[i], func, (char *) args + i * stride);
+        TAILQ_INSERT_TAIL(&batch, out[i], threads);
+        number_thread++;
+    }
+    add_threads_to_queue_tail(&batch, n);
+    enable_interrupt();
     return 0;
 }
 
+/**
+ * Auto-ajustement : sans taille de pile explicite, on choisit la classe d'après
+ * les plus hautes marques déjà observées pour cette fonction.
+ * Renvoie les attributs à utiliser (tuned s'ils ont été ajustés)
+ */
+static const thread_attr_t *attr_autotune(const thread_attr_t *attr, thread_attr_t *tuned,
+                                          void *(*func)(void *)){
+    if (stack_autotune && (attr == NULL || (attr->stack_size == 0 && !attr->shared_stack))) {
+        if (attr == NULL) {
+            thread_attr_init(tuned);
+        }
+        else {
+            *tuned = *attr;
+        }
+        tuned->stack_size = stack_autotune_size(func);
+        return tuned;
+    }
+    return attr;
+}
+
+/**
+ * Préparer un thread initialisé à exécuter func(funcarg)
+ */
+static void thread_prepare(struct thread *thread, void *(*func)(void *), void *funcarg){
+    thread->func = func;
+    if (stack_profiling && thread->stack_class >= 0) {
+        stack_paint(thread);
+    }
+    context_make(&thread->ctx, thread->stack, thread->stack_size, func, funcarg);
+}
+
 /**
     @fn extern int thread_yield(void)
     @brief Passer la main à un autre thread.
@@ -111,17 +620,16 @@ extern int thread_create(thread_t *newthread, void *(*func)(void *), void *funca
     @return 0 si la fonction s'est exécutée avec succès.
 */
 extern int thread_yield(void){
-    #ifdef PREEMPTION
     disable_interrupt();
-    #endif
     struct thread *self = thread_self();
-    if (self != NULL && self->is_locked != 1) {
+    if (self != NULL) {
         remove_thread_from_queue(self);
         update_thread_priority(self);
         add_thread_to_queue_tail(self);
         current_thread = get_thread();
         handle_swap(self,current_thread);
     }
+    enable_interrupt();
     return 0;
 }
 
@@ -134,14 +642,14 @@ extern int thread_yield(void){
  */
 extern int thread_join(thread_t thread, void **retval){
     //printf("joining %p\n", thread);
-    #ifdef PREEMPTION
     disable_interrupt();
-    #endif
-    if(thread == NULL) {
+    if(thread == NULL || thread->detached) {
+        enable_interrupt();
         return -1;
     }
-    if(!thread->is_done){
+    if(thread->state != THREAD_DONE){
         if(thread->id == current_thread->id_first) {
+            enable_interrupt();
             return EDEADLK;
         }
         if(thread->id_first == -1){
@@ -154,31 +662,129 @@ extern int thread_join(thread_t thread, void **retval){
         }
         //printf("here1 %p\n", thread);
         thread->joiner = current_thread;
-        remove_thread_from_queue(thread->joiner);
-        update_thread_priority(thread->joiner);
-        current_thread = get_thread();
-        handle_swap(thread->joiner,current_thread);
+        join_wait(thread->joiner, 1);
         //printf("here2 %p\n", thread);
     }
     if(retval!=NULL){
         *retval = thread->retval;
     }
     if(thread!=main_thread){
-        //printf("not main ending %p\n", thread);
-        thread_signal_free(thread->th); 
-        VALGRIND_STACK_DEREGISTER(thread->valgrind_stackid);
-        #ifdef STACKOVERFLOW
-        mprotect(thread->uc.uc_stack.ss_sp-PAGE_SIZE, PAGE_SIZE, PROT_READ | PROT_WRITE);
-        free(thread->uc.uc_stack.ss_sp-PAGE_SIZE);
-        #else 
-        free(thread->uc.uc_stack.ss_sp);
-        #endif
-        free(thread);
-        //printf("end not main %p\n", thread);
+        thread_free(thread);
     }
+    enable_interrupt();
     return 0; 
 }
 
+/**
+    @fn extern int thread_detach(thread_t thread)
+    @brief Détacher un thread : sa pile et son descripteur seront libérés dès sa terminaison.
+    Un thread détaché ne peut plus être joint. S'il est déjà terminé, il est libéré immédiatement.
+    @return 0 si réussi, -1 si le thread est NULL, déjà détaché ou déjà attendu par un autre thread
+ */
+extern int thread_detach(thread_t thread){
+    if (thread == NULL || thread->detached || thread->joiner != NULL) {
+        return -1;
+    }
+    disable_interrupt();
+    if (thread->state == THREAD_DONE && thread != main_thread) {
+        thread_free(thread);
+    }
+    else {
+        thread->detached = 1;
+    }
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn extern int thread_join_many(thread_t *threads, int n, void **retvals)
+    @brief Attendre la fin de n threads en ne se bloquant qu'une fois.
+    Le thread courant devient le joiner de tous les threads non terminés, puis se bloque
+    avec un compte à rebours que chaque terminaison décrémente : seule la dernière le réveille.
+    @param threads Tableau des threads à attendre, tous distincts
+    @param n Nombre de threads
+    @param retvals Tableau recevant les valeurs de retour, ou NULL
+    @return 0 si réussi, -1 si un thread est invalide, EDEADLK si le thread courant est attendu
+ */
+extern int thread_join_many(thread_t *threads, int n, void **retvals){
+    disable_interrupt();
+    int i, pending = 0;
+    int err = join_check(threads, n);
+    if (err != 0) {
+        enable_interrupt();
+        return err;
+    }
+    for (i = 0; i < n; i++) {
+        if (threads[i]->state != THREAD_DONE) {
+            threads[i]->joiner = current_thread;
+            pending++;
+        }
+    }
+    if (pending > 0) {
+        join_wait(current_thread, pending);
+    }
+    for (i = 0; i < n; i++) {
+        if (retvals != NULL) {
+            retvals[i] = threads[i]->retval;
+        }
+        if (threads[i] != main_thread) {
+            thread_free(threads[i]);
+        }
+    }
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn extern int thread_join_any(thread_t *threads, int n, void **retval)
+    @brief Attendre la fin du premier des n threads à se terminer.
+    Le thread courant se bloque une seule fois ; le premier thread qui se termine le réveille
+    et s'inscrit dans join_first. Les autres threads redeviennent joignables.
+    @param threads Tableau des threads à attendre, tous distincts
+    @param n Nombre de threads
+    @param retval Reçoit la valeur de retour du thread joint, ou NULL
+    @return Indice du thread joint, -1 si un thread est invalide, EDEADLK si le thread courant est attendu
+ */
+extern int thread_join_any(thread_t *threads, int n, void **retval){
+    disable_interrupt();
+    int i, index = -1;
+    struct thread *self = current_thread;
+    int err = join_check(threads, n);
+    if (err != 0 || n <= 0) {
+        enable_interrupt();
+        return err != 0 ? err : -1;
+    }
+    /**
+     * Un thread déjà terminé est joint sans se bloquer
+     */
+    for (i = 0; i < n && index < 0; i++) {
+        if (threads[i]->state == THREAD_DONE) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        for (i = 0; i < n; i++) {
+            threads[i]->joiner = self;
+        }
+        self->join_first = NULL;
+        join_wait(self, 1);
+        for (i = 0; i < n; i++) {
+            threads[i]->joiner = NULL;
+            if (threads[i] == self->join_first) {
+                index = i;
+            }
+        }
+    }
+    if (retval != NULL) {
+        *retval = threads[index]->retval;
+    }
+    if (threads[index] != main_thread) {
+        thread_free(threads[index]);
+    }
+    enable_interrupt();
+    return index;
+}
+
 /** 
     @brief le thread courant en renvoyant la valeur de retour retval.
     cette fonction ne retourne jamais.
@@ -188,674 +794,2466 @@ extern int thread_join(thread_t thread, void **retval){
     n'est pas correctement implémenté (il ne doit jamais retourner).
  */
 extern void thread_exit(void *retval){
-    #ifdef PREEMPTION
+    /**
+     * Les destructeurs des clés sont du code utilisateur : ils s'exécutent hors section critique
+     */
+    thread_key_destroy_values(current_thread);
     disable_interrupt();
-    #endif
     thread_t self = thread_self();
+    if (self->painted) {
+        stack_profile_record(self);
+    }
     self->retval = retval;
-    self->is_done = 1;
-    remove_thread_from_queue(self);
-    update_thread_priority(self);
+    self->state = THREAD_DONE;
     number_thread--;
-    if(self->joiner){
-        add_thread_to_queue_head(self->joiner);
+    struct thread *joiner = NULL;
+    if(self->joiner && self->joiner->join_first == NULL){
+        self->joiner->join_first = self;
     }
-    current_thread = get_thread();
+    if(self->joiner && --self->joiner->join_pending == 0){
+        joiner = self->joiner;
+    }
+    /**
+     * Passage direct au thread qui nous attend : il récupère retval dès sa reprise
+     */
+    if (joiner != NULL && join_handoff(self, joiner)) {
+        current_thread = joiner;
+    }
+    else {
+        remove_thread_from_queue(self);
+        if (joiner != NULL) {
+            add_thread_to_queue_head(joiner);
+        }
+        current_thread = get_thread();
+    }
+    update_thread_priority(self);
     handle_swap(self,current_thread);
     exit(0);
 }
 
 /************************************
-    Implementation des Mutex 
+    Données propres aux threads
 *************************************/
 
-int thread_mutex_init(thread_mutex_t *mutex) {
-    mutex->locked = NULL;
-    return 0;
-}
-
-int thread_mutex_destroy(thread_mutex_t *mutex) {
-    (void) mutex;
-    return 0; 
-}
-
-int thread_mutex_lock(thread_mutex_t *mutex) {
-    mutex->locked = thread_self();
-    mutex->locked->is_locked = 1;
+/**
+    @fn int thread_key_create(thread_key_t *key, void (*destructor)(void *))
+    @brief Créer une clé, dont la valeur vaut NULL dans tous les threads
+    @param destructor Appelé à la terminaison d'un thread sur sa valeur non NULL, ou NULL
+    @return 0 si réussi, -1 si key est NULL, EAGAIN si THREAD_KEYS_MAX clés ont déjà été créées
+ */
+int thread_key_create(thread_key_t *key, void (*destructor)(void *)){
+    if (key == NULL) {
+        return -1;
+    }
+    disable_interrupt();
+    if (nb_keys == THREAD_KEYS_MAX) {
+        enable_interrupt();
+        return EAGAIN;
+    }
+    thread_keys[nb_keys].destructor = destructor;
+    thread_keys[nb_keys].used = 1;
+    *key = nb_keys++;
+    enable_interrupt();
     return 0;
 }
 
-int thread_mutex_unlock(thread_mutex_t *mutex) {
-    mutex->locked->is_locked = 0;
-    mutex->locked = NULL;
+/**
+    @fn int thread_key_delete(thread_key_t key)
+    @brief Supprimer une clé ; les valeurs restantes ne sont pas passées au destructeur
+    @return 0 si réussi, -1 si la clé n'existe pas
+ */
+int thread_key_delete(thread_key_t key){
+    if (key >= nb_keys || !thread_keys[key].used) {
+        return -1;
+    }
+    thread_keys[key].used = 0;
+    thread_keys[key].destructor = NULL;
     return 0;
 }
 
-
-
-/************************************
-    Implementation des Sémaphores 
-*************************************/
-
 /**
- *  @struct thread_sem
- *  @brief Structure de notre sémaphore
+    @fn void *thread_getspecific(thread_key_t key)
+    @brief Valeur de la clé pour le thread courant, NULL s'il n'y a rien rangé
  */
-struct thread_sem{
-    atomic_int max_resources;       /*!<Nombre maximal de ressources*/
-    atomic_int current_resources;   /*!<Nombre actuel de ressources*/
-    atomic_int destroyed;           /*!<Indicateur de destruction*/
-    thread_mutex_t *lock;           /*!<Mutex pour protéger la sémaphore */
-};
+void *thread_getspecific(thread_key_t key){
+    struct thread *self = current_thread;
+    return key < self->specific_size ? self->specific[key] : NULL;
+}
 
 /**
-    @fn int thread_sem_init(thread_sem_t *sem, int pshared, unsigned int value)
-    @brief Fonction d'initialisation de notre sémaphore
-    @param sem Pointeur vers la sémaphore à initialiser
-    @param pshared Ignoré (toujours égal à zéro)
-    @param value Valeur initiale de la sémaphore
-    @return int 0 si l'initialisation a réussi, -1 sinon 
+    @fn int thread_setspecific(thread_key_t key, const void *value)
+    @brief Ranger une valeur pour la clé dans le thread courant
+    @return 0 si réussi, -1 si la clé n'existe pas, ENOMEM si les cases n'ont pas pu être agrandies
  */
-int thread_sem_init(thread_sem_t *sem, int pshared, unsigned int value){
-
-    /**
-    * allocation de la mémoire allouée à la sémaphore 
-    */ 
-    *sem = malloc(sizeof(struct thread_sem));
-
-    assert(pshared==0);
-    if(*sem == NULL){
+int thread_setspecific(thread_key_t key, const void *value){
+    struct thread *self = current_thread;
+    if (key >= nb_keys || !thread_keys[key].used) {
         return -1;
     }
     /**
-     * allocation et initialisation des champs de la sémaphore
+     * Au-delà des cases du descripteur, les cases sont allouées en doublant leur nombre
      */
-    atomic_init(&((*sem)->destroyed), 0);
-    atomic_init(&((*sem)->max_resources), value);
-    atomic_init(&((*sem)->current_resources), value);
-    (*sem)->lock = malloc(sizeof(thread_mutex_t));
-    if (thread_mutex_init((*sem)->lock) != 0) {
-            return -1;
+    if (key >= self->specific_size) {
+        unsigned int size = self->specific_size * 2;
+        void **specific;
+        while (size <= key) {
+            size *= 2;
+        }
+        specific = malloc(size * sizeof(void *));
+        if (specific == NULL) {
+            return ENOMEM;
+        }
+        memcpy(specific, self->specific, self->specific_size * sizeof(void *));
+        memset(specific + self->specific_size, 0, (size - self->specific_size) * sizeof(void *));
+        if (self->specific != self->specific_inline) {
+            free(self->specific);
+        }
+        self->specific = specific;
+        self->specific_size = size;
     }
+    self->specific[key] = (void *) value;
     return 0;
 }
 
 /**
-    @fn int thread_sem_destroy(thread_sem_t *sem)
-    @brief fonction de destruction de notre sémaphore
-    @param sem Pointeur vers la sémaphore à détruire
-    @return int 0 si la destruction a réussi, -1 sinon 
+ * Passer les valeurs non NULL du thread aux destructeurs de leur clé. Un destructeur
+ * peut ranger une nouvelle valeur : on recommence, au plus THREAD_DESTRUCTOR_ITERATIONS fois
  */
-int thread_sem_destroy(thread_sem_t *sem){
-    thread_mutex_lock((*sem)->lock);
-    atomic_store(&((*sem)->destroyed), 1);
-    /**
-     * Si des threads sont en attente, on les réveille
-     */
-    while (atomic_load(&((*sem)->current_resources)) < atomic_load(&((*sem)->max_resources))) {
-        thread_yield();
+static void thread_key_destroy_values(struct thread *thread){
+    for (int round = 0; round < THREAD_DESTRUCTOR_ITERATIONS; round++) {
+        int called = 0;
+        for (unsigned int key = 0; key < nb_keys && key < thread->specific_size; key++) {
+            void *value = thread->specific[key];
+            if (value == NULL || thread_keys[key].destructor == NULL) {
+                continue;
+            }
+            thread->specific[key] = NULL;
+            thread_keys[key].destructor(value);
+            called = 1;
+        }
+        if (!called) {
+            return;
+        }
+    }
+}
+
+/************************************
+    Portées de threads
+*************************************/
+
+/**
+    @fn int thread_scope_init(thread_scope_t *scope)
+    @brief Initialiser une portée vide
+    @return 0 si réussi, -1 si scope est NULL
+ */
+int thread_scope_init(thread_scope_t *scope){
+    if (scope == NULL) {
+        return -1;
     }
-    thread_mutex_unlock((*sem)->lock);
-    thread_mutex_destroy((*sem)->lock);
-    free(*sem);
+    scope->threads = NULL;
+    scope->count = 0;
     return 0;
 }
 
 /**
-    @fn int thread_sem_wait(thread_sem_t sem)
-    @brief Fonction d'attente d'un thread sur une sémaphore
-    @param sem Sémaphore sur laquelle le thread attend
-    @return int 0 si le thread a réussi à acquérir la ressource, -1 si la sémaphore a été détruite
+    @fn int thread_scope_spawn(thread_scope_t *scope, thread_t *newthread, void *(*func)(void *), void *funcarg)
+    @brief Créer un thread rattaché à la portée, qui sera joint par thread_scope_join()
+    @param newthread Reçoit l'identifiant du thread, ou NULL
+    @return 0 si réussi, -1 en cas d'erreur
  */
-int thread_sem_wait(thread_sem_t sem) {
-    thread_mutex_lock(sem->lock);
-    
-    /**
-     * Tant que le nombre de ressources est null, on passe la main,
-     * sinon on décrémente le nombre de ressources
-     */
-    while (atomic_load(&(sem->current_resources)) == 0) {
-        /**
-         * Si la sémaphore a été détruite, on renvoie -1
-         */
-        if (atomic_load(&(sem->destroyed))) {
-            thread_mutex_unlock(sem->lock);
-            return -1;
-        }
-        
-        thread_mutex_unlock(sem->lock);
-        thread_yield();
-        thread_mutex_lock(sem->lock);
+int thread_scope_spawn(thread_scope_t *scope, thread_t *newthread,
+                       void *(*func)(void *), void *funcarg){
+    thread_t thread;
+    if (scope == NULL || thread_create(&thread, func, funcarg) != 0) {
+        return -1;
+    }
+    thread->scope_next = scope->threads;
+    scope->threads = thread;
+    scope->count++;
+    if (newthread != NULL) {
+        *newthread = thread;
     }
-    
-    atomic_fetch_sub(&(sem->current_resources), 1);
-    thread_mutex_unlock(sem->lock);
     return 0;
 }
 
 /**
-    @fn int thread_sem_post(thread_sem_t sem)
-    @brief Fonction d'incrémentation du sémaphore
-    @param sem Sémaphore à incrémenter
-    @return int 0 si l'incrémentation a réussi, -1 sinon
+    @fn int thread_scope_join(thread_scope_t *scope)
+    @brief Joindre tous les threads de la portée en ne se bloquant qu'une fois
+    La portée est vide au retour et peut être réutilisée.
+    @return 0 si réussi, -1 si scope est NULL
  */
-int thread_sem_post(thread_sem_t sem){
-    thread_mutex_lock(sem->lock);
-    
-    /**
-     * Si le nombre de ressources courantes est bien inférieur au nombre de ressources maximales
-     */
-    if (atomic_load(&(sem->current_resources)) < atomic_load(&(sem->max_resources))) {
-        atomic_fetch_add(&(sem->current_resources), 1);
+int thread_scope_join(thread_scope_t *scope){
+    disable_interrupt();
+    struct thread *thread, *next;
+    int pending = 0;
+    if (scope == NULL) {
+        enable_interrupt();
+        return -1;
     }
-    
-    thread_mutex_unlock(sem->lock);
+    for (thread = scope->threads; thread != NULL; thread = thread->scope_next) {
+        if (thread->state != THREAD_DONE) {
+            thread->joiner = current_thread;
+            pending++;
+        }
+    }
+    if (pending > 0) {
+        join_wait(current_thread, pending);
+    }
+    for (thread = scope->threads; thread != NULL; thread = next) {
+        next = thread->scope_next;
+        thread_free(thread);
+    }
+    scope->threads = NULL;
+    scope->count = 0;
+    enable_interrupt();
     return 0;
 }
 
 /************************************
-    Implementation des Barrières
+    Tâches en ligne (spawn/sync)
 *************************************/
 
 /**
-    @struct thread_barrier
-    @brief Structure de nos barrières
+    @fn int thread_spawn(thread_task_t *task, void *(*func)(void *), void *arg)
+    @brief Lancer func(arg) en ligne sur la pile du thread courant, ou dans un nouveau thread.
+    Avec un seul worker, aucun autre thread noyau ne peut voler la continuation de l'appelant :
+    exécuter l'enfant tout de suite ne change rien au résultat. L'enfant n'est promu en véritable
+    thread que lorsqu'il reste moins de SPAWN_HEADROOM octets sur la pile courante.
+    @param task Tâche recevant la valeur de retour ou le thread promu
+    @return 0 si réussi, -1 si task ou func est NULL ou si la création du thread a échoué
  */
-struct thread_barrier{
-    atomic_int count;       /*!<Nombre total de threads devant atteindre la barrière */
-    atomic_int waiting;     /*!<Nombre de threads en attente sur la barrière*/
-    thread_mutex_t *lock;   /*!<Mutex pour la protection de la barrière*/
-};
+int thread_spawn(thread_task_t *task, void *(*func)(void *), void *arg){
+    if (task == NULL || func == NULL) {
+        return -1;
+    }
+    if (stack_headroom() >= SPAWN_HEADROOM) {
+        task->thread = NULL;
+        task->retval = func(arg);
+        return 0;
+    }
+    task->retval = NULL;
+    return thread_create(&task->thread, func, arg);
+}
 
 /**
-    @fn int thread_barrier_init(thread_barrier_t *barrier, unsigned int count)
-    @brief fonction d'initialisation de notre structure de barrière
-    @brief Initialise une barrière avec un nombre donné de threads attendus
-    @param barrier Pointeur vers la structure de barrière à initialiser
-    @param count Nombre total de threads devant atteindre la barrière
-    @return 0 si l'initialisation a réussi, -1 sinon 
+    @fn int thread_sync(thread_task_t *tasks, int n)
+    @brief Attendre les enfants promus en ne se bloquant qu'une fois
+    Les enfants exécutés en ligne sont déjà terminés ; les autres ont le thread courant pour joiner
+    et le réveillent au dernier, comme dans thread_join_many().
+    @param tasks Tâches lancées par thread_spawn()
+    @param n Nombre de tâches
+    @return 0 si réussi, -1 si tasks est NULL
  */
-int thread_barrier_init(thread_barrier_t *barrier, unsigned int count){
-    /**
-     *  On s'assure que count est strictement positif
-     *  Car on ne peut attendre un nombre négatif ou zéro thread 
-     */
-    if (count <= 0) {
+int thread_sync(thread_task_t *tasks, int n){
+    disable_interrupt();
+    int i, pending = 0;
+    if (tasks == NULL) {
+        enable_interrupt();
         return -1;
     }
-    /**
-     * on initialise les champs de notre barrier 
-     */
-    *barrier = malloc(sizeof(struct thread_barrier));
-    if (*barrier == NULL) {
-        return -1;
+    for (i = 0; i < n; i++) {
+        if (tasks[i].thread != NULL && tasks[i].thread->state != THREAD_DONE) {
+            tasks[i].thread->joiner = current_thread;
+            pending++;
+        }
     }
-    atomic_init(&((*barrier)->count), count);
-    atomic_init(&((*barrier)->waiting), 0);
-    (*barrier)->lock = malloc(sizeof(thread_mutex_t));
-    if (thread_mutex_init((*barrier)->lock) != 0) {
-        free(*barrier);
-        return -1;
+    if (pending > 0) {
+        join_wait(current_thread, pending);
+    }
+    for (i = 0; i < n; i++) {
+        if (tasks[i].thread != NULL) {
+            tasks[i].retval = tasks[i].thread->retval;
+            thread_free(tasks[i].thread);
+            tasks[i].thread = NULL;
+        }
     }
+    enable_interrupt();
     return 0;
 }
 
+/************************************
+    Tâches sans pile
+*************************************/
+
 /**
-    @fn int thread_barrier_wait(thread_barrier_t barrier)
-    @brief fonction d'attente sur une barrier
-    @brief Attend sur la barrière jusqu'à ce que tous les threads attendus aient atteint la barrière
-    @param barrier Structure de barrière à attendre
-    @return 0 si tous les threads attendus ont atteint la barrière
+    @fn thread_job_t thread_task_submit(void *(*func)(void *), void *arg)
+    @brief Soumettre une tâche sans pile.
+    La tâche est placée dans la file du worker ; elle sera exécutée avec les autres tâches en attente
+    sur la pile de l'ordonnanceur, au prochain changement de contexte ou au premier thread_task_join().
+    @return Identifiant de la tâche, NULL si func est NULL ou en cas d'erreur d'allocation
  */
-int thread_barrier_wait(thread_barrier_t barrier){
-    thread_mutex_lock(barrier->lock);
-   
-    /**
-     * Si le nombre de threads en attente est égal au nombre de threads attendu
-     * Bingo !!! 
-     */
-    if (atomic_load(&(barrier->waiting)) == atomic_load(&(barrier->count))) {
-        atomic_store(&(barrier->waiting), 0);
-        atomic_fetch_sub(&(barrier->count), atomic_load(&(barrier->count)));
-        thread_mutex_unlock(barrier->lock);
-        return 0;
-    } else {
-        /**
-         * incrémente le nombre de thread en attente sur la barrier
-         */
-        atomic_fetch_add(&(barrier->waiting), 1);
-
-        /**
-         * Sinon on suspend le thread en attente jusqu'à ce que le soit le cas
-         */
-        while (atomic_load(&(barrier->waiting)) != atomic_load(&(barrier->count))) {
-            thread_mutex_unlock(barrier->lock);
-            thread_yield();
-            thread_mutex_lock(barrier->lock);
-        }
-        /**
-         * On remet les compteurs à zéro 
-         */
-        atomic_store(&(barrier->waiting), 0);
-        atomic_fetch_sub(&(barrier->count), atomic_load(&(barrier->count)));
-        thread_mutex_unlock(barrier->lock);
-        return 0;
+thread_job_t thread_task_submit(void *(*func)(void *), void *arg){
+    struct thread_job *job;
+    if (func == NULL || (job = malloc(sizeof(*job))) == NULL) {
+        return NULL;
     }
+    job->func = func;
+    job->arg = arg;
+    job->retval = NULL;
+    job->done = 0;
+    disable_interrupt();
+    STAILQ_INSERT_TAIL(&worker.tasks, job, next);
+    enable_interrupt();
+    return job;
 }
 
 /**
-    @fn int thread_barrier_destroy(thread_barrier_t *barrier)
-    @brief Détruit une barrière et libère les ressources associées
-    @param barrier Pointeur vers la structure de barrière à détruire
-    @return 0 si la destruction a réussi, -1 sinon
+    @fn int thread_task_join(thread_job_t job, void **retval)
+    @brief Attendre la fin d'une tâche.
+    Une tâche ne bloque jamais : si elle n'est pas encore terminée, le thread courant exécute
+    toutes les tâches en attente sur la pile de l'ordonnanceur puis reprend aussitôt.
+    @return 0 si réussi, -1 si job est NULL
  */
-int thread_barrier_destroy(thread_barrier_t *barrier){
-    thread_mutex_destroy((*barrier)->lock);
-    free((*barrier)->lock);
-    free(*barrier);
+int thread_task_join(thread_job_t job, void **retval){
+    disable_interrupt();
+    if (job == NULL) {
+        enable_interrupt();
+        return -1;
+    }
+    if (!job->done) {
+        context_switch_call(&current_thread->ctx, sched_hook, current_thread,
+                            worker.sched_stack + SCHED_STACK_SIZE);
+    }
+    if (retval != NULL) {
+        *retval = job->retval;
+    }
+    free(job);
+    enable_interrupt();
     return 0;
 }
 
+/**
+ * Exécuter toutes les tâches en attente, y compris celles soumises pendant l'exécution
+ */
+static void tasks_run(void){
+    struct thread_job *job;
+    while ((job = STAILQ_FIRST(&worker.tasks)) != NULL) {
+        STAILQ_REMOVE_HEAD(&worker.tasks, next);
+        job->retval = job->func(job->arg);
+        job->done = 1;
+    }
+}
+
 /************************************
-    Implementation des thread_cond
+    Attributs de threads
 *************************************/
 
 /**
-    @struct thread_cond
-    @brief Structure pour une condition de thread
-*/
-struct thread_cond {
-    TAILQ_HEAD(cond_queue, thread) queue_cond; /*!<File d'attente de threads en attente de la condition*/
-};
-
-/**
-    @fn int thread_cond_init(thread_cond_t *cond)
-    @brief Initialise la condition spécifiée
-    @param cond Pointeur vers la condition à initialiser
-    @return 0 si réussi, -1 si une erreur est survenue
-    Cette fonction alloue de la mémoire pour la condition spécifiée et initialise ses champs, y compris sa file d'attente.
-*/
-int thread_cond_init(thread_cond_t *cond) {
-    /**
-     * Allocation de la mémoire pour la condition 
-     */
-    *cond = malloc(sizeof(struct thread_cond));
-    if (*cond == NULL) {
+    @fn int thread_attr_init(thread_attr_t *attr)
+    @brief Initialiser des attributs avec les valeurs par défaut
+    @param attr Attributs à initialiser
+    @return 0 si réussi, -1 si attr est NULL
+ */
+int thread_attr_init(thread_attr_t *attr){
+    if (attr == NULL) {
         return -1;
     }
-    /**
-     * initialisation des champs de la condition
-     */
-    TAILQ_INIT(&((*cond)->queue_cond));
+    attr->stack_size = 0;
+    attr->priority = -1;
+    attr->shared_stack = 0;
+    attr->detached = THREAD_CREATE_JOINABLE;
+    attr->timeslice = 0;
     return 0;
 }
 
 /**
-    @brief Attend la condition spécifiée
-    @param cond Condition à attendre
-    @param mutex Verrou à utiliser pour la synchronisation
-    @return 0 si réussi, -1 si une erreur est survenue
-    Cette fonction ajoute le thread courant à la file d'attente de la condition, relâche le verrou, suspend le thread courant, puis acquiert à nouveau le verrou.
-*/
-int thread_cond_wait(thread_cond_t cond, thread_mutex_t *mutex) {
-    /**
-    * Vérifie que les arguments sont bien définis 
-    */
-    if (cond == NULL || mutex == NULL) {
+    @fn int thread_attr_destroy(thread_attr_t *attr)
+    @brief Détruire des attributs (aucune ressource n'est associée)
+    @param attr Attributs à détruire
+    @return 0 si réussi, -1 si attr est NULL
+ */
+int thread_attr_destroy(thread_attr_t *attr){
+    return attr == NULL ? -1 : 0;
+}
+
+/**
+    @fn int thread_attr_setstacksize(thread_attr_t *attr, size_t stacksize)
+    @brief Choisir la taille de pile des threads créés avec ces attributs
+    La taille est arrondie à la classe de taille supérieure (puissance de deux, au moins THREAD_STACK_MIN).
+    @param attr Attributs à modifier
+    @param stacksize Taille de pile souhaitée en octets, 0 pour la taille par défaut
+    @return 0 si réussi, -1 si attr est NULL ou si la taille dépasse THREAD_STACK_MAX
+ */
+int thread_attr_setstacksize(thread_attr_t *attr, size_t stacksize){
+    if (attr == NULL || stacksize > THREAD_STACK_MAX) {
         return -1;
     }
-    
-    /**
-     * Ajouter le thread courant à la file d'attente de la condition
-     */
-    TAILQ_INSERT_TAIL(&(cond->queue_cond), current_thread, threads);
-
-    /**
-     * Relâcher le verrou et suspendre le thread courant
-     */
-    thread_mutex_unlock(mutex);
-    TAILQ_REMOVE(&ready, current_thread, threads);
-    thread_yield();
+    attr->stack_size = stacksize;
+    return 0;
+}
 
-    /**
-     * Récupérer le premier thread de la file d'attente de la condition
-     */
-    thread_t thread = TAILQ_FIRST(&(cond->queue_cond));
-    while (thread != current_thread) {
-        /**
-         * Si ce n'est pas le thread courant, le retirer de la file d'attente et le remettre dans la queue de threads prêts
-         */
-        TAILQ_REMOVE(&(cond->queue_cond), thread, threads);
-        add_thread_to_queue_tail(thread);
-        thread = TAILQ_FIRST(&(cond->queue_cond));
+/**
+    @fn int thread_attr_getstacksize(const thread_attr_t *attr, size_t *stacksize)
+    @brief Récupérer la taille de pile demandée dans les attributs
+    @return 0 si réussi, -1 si un des arguments est NULL
+ */
+int thread_attr_getstacksize(const thread_attr_t *attr, size_t *stacksize){
+    if (attr == NULL || stacksize == NULL) {
+        return -1;
     }
-
-    /**
-     * Retirer le thread courant de la file d'attente de la condition
-     */
-    TAILQ_REMOVE(&(cond->queue_cond), current_thread, threads);
-
-    /**
-     * Acquérir à nouveau le verrou
-     */
-    thread_mutex_lock(mutex);
+    *stacksize = attr->stack_size ? attr->stack_size : CONTEXT_STACK_SIZE;
     return 0;
 }
 
 /**
-    @fn int thread_cond_signal(thread_cond_t cond)
-    @brief Signale un thread en attente de la condition spécifiée
-    @param cond Condition à signaler
-    @return 0 si réussi, -1 si une erreur est survenue
-    Cette fonction récupère le premier thread en attente de la condition spécifiée et le remet dans la queue de threads prêts.
-*/
-int thread_cond_signal(thread_cond_t cond) {
-    if (cond == NULL) {
+    @fn int thread_attr_setpriority(thread_attr_t *attr, int priority)
+    @brief Choisir la priorité initiale des threads créés avec ces attributs
+    Seul l'ordonnancement par priorité en tient compte.
+    @param priority Priorité entre 0 et MAX_PRIORITY-1, ou -1 pour la valeur par défaut
+    @return 0 si réussi, -1 si attr est NULL ou la priorité hors bornes
+ */
+int thread_attr_setpriority(thread_attr_t *attr, int priority){
+    if (attr == NULL || priority < -1 || priority >= MAX_PRIORITY) {
         return -1;
     }
-    /**
-     * Récupérer le premier thread de la file d'attente de la condition
-     */
-    thread_t thread = TAILQ_FIRST(&(cond->queue_cond));
+    attr->priority = priority;
+    return 0;
+}
 
-    if (thread != NULL) {
-        /**
-         * Si la file d'attente n'est pas vide, retirer le premier thread et le remettre dans la queue de threads prêts
-         */
-        TAILQ_REMOVE(&(cond->queue_cond), thread, threads);
-        add_thread_to_queue_tail(thread);
+/**
+    @fn int thread_attr_setsharedstack(thread_attr_t *attr, int shared)
+    @brief Choisir le mode pile partagée pour les threads créés avec ces attributs
+    Un tel thread s'exécute sur la pile partagée du worker ; lorsqu'un autre thread
+    a besoin de cette pile, seule la partie vivante de la sienne est copiée dans le tas.
+    La taille de pile demandée est alors ignorée.
+    @param shared 1 pour le mode pile partagée, 0 pour une pile dédiée
+    @return 0 si réussi, -1 si attr est NULL
+ */
+int thread_attr_setsharedstack(thread_attr_t *attr, int shared){
+    if (attr == NULL) {
+        return -1;
     }
-
+    attr->shared_stack = shared != 0;
     return 0;
 }
 
 /**
-    @fn int thread_cond_broadcast(thread_cond_t cond)
-    @brief Signale tous les threads en attente de la condition spécifiée
-    @param cond Condition à signaler
-    @return 0 si réussi, -1 si une erreur est survenue
-    Cette fonction récupère tous les threads en attente de la condition spécifiée et les remet dans la queue de threads prêts.
-*/
-int thread_cond_broadcast(thread_cond_t cond) {
-    if (cond == NULL) {
+    @fn int thread_attr_setdetachstate(thread_attr_t *attr, int detachstate)
+    @brief Créer les threads détachés (THREAD_CREATE_DETACHED) ou joignables (THREAD_CREATE_JOINABLE)
+    @return 0 si réussi, -1 si attr est NULL ou detachstate invalide
+ */
+int thread_attr_setdetachstate(thread_attr_t *attr, int detachstate){
+    if (attr == NULL || (detachstate != THREAD_CREATE_JOINABLE && detachstate != THREAD_CREATE_DETACHED)) {
         return -1;
     }
-    /**
-     * Pour chaque thread de la file d'attente de la condition, le retirer et le remettre dans la queue de threads prêts
-     */
-    while (!TAILQ_EMPTY(&(cond->queue_cond))) {
-        thread_t thread = TAILQ_FIRST(&(cond->queue_cond));
-        TAILQ_REMOVE(&(cond->queue_cond), thread, threads);
-        add_thread_to_queue_tail(thread);
-    }
-
+    attr->detached = detachstate;
     return 0;
 }
 
 /**
-    @fn int thread_cond_destroy(thread_cond_t *cond)
-    @brief Détruit la condition spécifiée
-    @param cond Pointeur vers la condition à détruire
-    @return 0 si réussi, -1 si une erreur est survenue
-    Cette fonction libère la mémoire allouée pour la condition spécifiée.
-*/
-int thread_cond_destroy(thread_cond_t *cond) {
-    if (cond == NULL || *cond == NULL) {
+    @fn int thread_attr_settimeslice(thread_attr_t *attr, unsigned long usec)
+    @brief Choisir la tranche de temps des threads créés avec ces attributs
+    @param usec Tranche de temps en microsecondes, 0 pour la tranche par défaut
+    @return 0 si réussi, -1 si attr est NULL ou la tranche inférieure à THREAD_TIMESLICE_MIN
+ */
+int thread_attr_settimeslice(thread_attr_t *attr, unsigned long usec){
+    if (attr == NULL || (usec != 0 && usec < THREAD_TIMESLICE_MIN)) {
         return -1;
     }
+    attr->timeslice = usec;
+    return 0;
+}
 
-    free(*cond);
-    *cond = NULL;
-
+/**
+    @fn int thread_set_stack_watermark(size_t bytes)
+    @brief Choisir la partie haute des piles conservée en mémoire lors de leur recyclage
+    Au-delà de ce seuil, les pages d'une pile recyclée sont rendues au système.
+    @param bytes Seuil en octets, arrondi au multiple de la taille de page supérieur
+    @return 0
+ */
+int thread_set_stack_watermark(size_t bytes){
+    stack_watermark = (bytes + PAGE_SIZE - 1) & ~((size_t)PAGE_SIZE - 1);
     return 0;
 }
 
-/*******************************  
-    Implementation Signaux 
-********************************/
+/**
+    @fn size_t thread_get_stack_watermark(void)
+    @brief Récupérer le seuil de conservation des piles recyclées
+    @return Seuil en octets
+ */
+size_t thread_get_stack_watermark(void){
+    return stack_watermark;
+}
 
-int thread_kill(thread_t *thread, int signal){
-    if(signal<NBR_SIGNALS && signal >= 0){
-        signal_t * signal_to_send = get_signal((signal_type)signal);
-        if(get_thread_current_signal(thread)<MAX_SIGNALS-1){
-            int index = get_thread_current_signal(thread);
-            set_thread_signal_array(thread,index,signal_to_send);
-            printf("thread %d sends %s signal to thread %d\n",current_thread->id,signal_enum_to_string(signal),(*thread)->id);
-            return 1;
+/************************************
+    Implementation des Mutex 
+*************************************/
+
+int thread_mutex_init(thread_mutex_t *mutex) {
+    mutex->word = 0;
+    mutex->waiters = NULL;
+    mutex->spin = 0;
+    mutex->profile = NULL;
+    mutex->since = 0;
+    if (lock_profiling) {
+        mutex->profile = lock_profile_lookup(__builtin_return_address(0), 1);
+        if (mutex->profile != NULL) {
+            mutex->profile->mutexes++;
         }
     }
     return 0;
 }
 
-int thread_signal_wait(int signal) {
-    if(signal<NBR_SIGNALS && signal >= 0){
-        signal_t * signal_to_wait_for = get_signal((signal_type)signal);
-        if (current_thread->th == NULL) {
-            return 0;
-        }
-        int index = current_thread->th->current_signal-1;
-        while(current_thread->th->signal_array[index] != signal_to_wait_for){
-            thread_yield();
+/**
+    @fn int thread_mutex_destroy(thread_mutex_t *mutex)
+    @brief Détruire un mutex
+    @return 0 si réussi, -1 si le mutex est encore pris
+ */
+int thread_mutex_destroy(thread_mutex_t *mutex) {
+    if (__atomic_load_n(&mutex->word, __ATOMIC_RELAXED) != 0) {
+        return -1;
+    }
+    return 0; 
+}
+
+/**
+    @fn int thread_mutex_lock(thread_mutex_t *mutex)
+    @brief Prendre un mutex, en se bloquant dans sa file d'attente s'il est déjà pris
+    Le chemin sans contention est un seul CAS du mot de verrou, de 0 au thread courant.
+    Le détenteur hérite de la priorité du thread bloqué si elle est plus haute que la sienne,
+    de proche en proche s'il attend lui-même un mutex.
+    @return 0 si réussi, EDEADLK si le thread courant détient déjà le mutex
+ */
+int thread_mutex_lock(thread_mutex_t *mutex) {
+    struct thread *self = current_thread, **last;
+    unsigned long word = 0, start;
+    if (__atomic_compare_exchange_n(&mutex->word, &word, (unsigned long) self, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        self->mutex_held++;
+        if (mutex->profile != NULL) {
+            lock_profile_acquired(mutex, 0);
         }
-        if (signal_to_wait_for->handler == NULL) {
-            default_signal_handler(signal_to_wait_for->type);
+        return 0;
+    }
+    if (MUTEX_OWNER(word) == self) {
+        return EDEADLK;
+    }
+    start = mutex->profile != NULL ? lock_profile_now() : 0;
+    if (mutex_spin(mutex, self)) {
+        if (mutex->profile != NULL) {
+            lock_profile_acquired(mutex, start);
         }
-        else {
-            signal_to_wait_for->handler(signal_to_wait_for->type);
+        return 0;
+    }
+    disable_interrupt();
+    /**
+     * Lever le bit d'attente : le détenteur passera par le chemin lent pour nous
+     * transmettre le mutex. Le mutex a pu être relâché entre-temps
+     */
+    word = __atomic_load_n(&mutex->word, __ATOMIC_RELAXED);
+    do {
+        if (word == 0) {
+            if (__atomic_compare_exchange_n(&mutex->word, &word, (unsigned long) self, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                self->mutex_held++;
+                if (mutex->profile != NULL) {
+                    lock_profile_acquired(mutex, start);
+                }
+                enable_interrupt();
+                return 0;
+            }
+            continue;
         }
-        return 1;
+    } while (!__atomic_compare_exchange_n(&mutex->word, &word, word | MUTEX_WAITERS, 0,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    for (last = &mutex->waiters; *last != NULL; last = &(*last)->wait_next) {
+    }
+    self->wait_next = NULL;
+    *last = self;
+    self->wait_mutex = mutex;
+    mutex_inherit(MUTEX_OWNER(word), self->priority);
+    /**
+     * thread_mutex_unlock() nous transmet le mutex avant de nous réveiller
+     */
+    thread_park(self);
+    if (mutex->profile != NULL) {
+        lock_profile_acquired(mutex, start);
     }
+    enable_interrupt();
     return 0;
 }
 
-int thread_signal_timed_wait(int signal, int timeout) {
-    if(signal<NBR_SIGNALS && signal >= 0){
-        signal_t * signal_to_wait_for = get_signal((signal_type)signal);
-        if (current_thread->th == NULL) {
-            return -1;
+/**
+    @fn int thread_mutex_unlock(thread_mutex_t *mutex)
+    @brief Relâcher un mutex et le transmettre au premier thread en attente
+    Sans thread en attente, un seul CAS remet le mot de verrou à 0.
+    Avec l'ordonnancement par priorité, le thread réveillé est le plus prioritaire des threads en
+    attente ; il hérite de la priorité de ceux qui restent. Le thread courant retrouve sa priorité
+    propre lorsqu'il ne détient plus aucun mutex.
+    @return 0 si réussi, -1 si le thread courant ne détient pas le mutex
+ */
+int thread_mutex_unlock(thread_mutex_t *mutex) {
+    struct thread *self = current_thread, *next, **link;
+    unsigned long word = (unsigned long) self;
+    if (mutex->profile != NULL && MUTEX_OWNER(mutex->word) == self) {
+        mutex->profile->hold_total += lock_profile_now() - mutex->since;
+    }
+    if (__atomic_compare_exchange_n(&mutex->word, &word, 0, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        if (--self->mutex_held == 0 && self->base_priority >= 0) {
+            disable_interrupt();
+            thread_set_effective_priority(self, self->base_priority);
+            self->base_priority = -1;
+            enable_interrupt();
         }
-        int i = 0;
-        int index = current_thread->th->current_signal -1;
-        while(current_thread->th->signal_array[index] != signal_to_wait_for){
-            thread_yield();
-            i++;
-            if(i>timeout){
-                break;
+        return 0;
+    }
+    if (MUTEX_OWNER(word) != self) {
+        return -1;
+    }
+    disable_interrupt();
+    if (--self->mutex_held == 0 && self->base_priority >= 0) {
+        thread_set_effective_priority(self, self->base_priority);
+        self->base_priority = -1;
+    }
+    next = NULL;
+    link = mutex_next_waiter(mutex);
+    if (link != NULL) {
+        next = *link;
+        *link = next->wait_next;
+        next->wait_next = NULL;
+        next->wait_mutex = NULL;
+        next->mutex_held++;
+    }
+    __atomic_store_n(&mutex->word, next == NULL ? 0 :
+                     (unsigned long) next | (mutex->waiters != NULL ? MUTEX_WAITERS : 0),
+                     __ATOMIC_RELEASE);
+    if (next != NULL) {
+        for (struct thread *waiter = mutex->waiters; waiter != NULL; waiter = waiter->wait_next) {
+            mutex_inherit(next, waiter->priority);
+        }
+        thread_unpark(next);
+    }
+    enable_interrupt();
+    return 0;
+}
+
+/**
+ * Attente active avant de se bloquer. La borne suit la moyenne glissante des itérations
+ * qui ont suffi, dans la limite de MUTEX_SPIN_MAX.
+ * Avec un seul worker, le détenteur ne s'exécute jamais en même temps que nous :
+ * l'attente s'arrête aussitôt. Renvoie 1 si le mutex a été pris
+ */
+static int mutex_spin(thread_mutex_t *mutex, struct thread *self){
+    int i, limit = mutex->spin * 2 + MUTEX_SPIN_MIN;
+    unsigned long word;
+    if (limit > MUTEX_SPIN_MAX) {
+        limit = MUTEX_SPIN_MAX;
+    }
+    for (i = 0; i < limit; i++) {
+        word = __atomic_load_n(&mutex->word, __ATOMIC_RELAXED);
+        if (word == 0) {
+            if (__atomic_compare_exchange_n(&mutex->word, &word, (unsigned long) self, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                mutex->spin += (i - mutex->spin) / 8;
+                self->mutex_held++;
+                return 1;
             }
+            continue;
         }
-        if (signal_to_wait_for->handler == NULL) {
-            default_signal_handler(signal_to_wait_for->type);
+        if (!thread_on_cpu(MUTEX_OWNER(word))) {
+            return 0;
+        }
+        #if defined(__x86_64__)
+        __builtin_ia32_pause();
+        #else
+        __asm__ __volatile__("" ::: "memory");
+        #endif
+    }
+    mutex->spin += (limit - mutex->spin) / 8;
+    return 0;
+}
+
+/**
+ * Le thread s'exécute-t-il en ce moment sur un worker ? Avec un seul worker,
+ * seul le thread courant s'exécute
+ */
+static int thread_on_cpu(struct thread *thread){
+    return thread == current_thread;
+}
+
+/************************************
+    Profilage des mutex
+*************************************/
+
+/**
+ * Date en ns sur l'horloge monotone
+ */
+static unsigned long lock_profile_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long) ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+/**
+ * Retrouver (ou créer) les statistiques d'un site d'initialisation
+ */
+static thread_lock_profile_t *lock_profile_lookup(void *site, int create){
+    unsigned long bucket = ((uintptr_t)site >> 4) % LOCK_PROFILE_BUCKETS;
+    struct lock_profile_entry *entry = lock_profiles[bucket];
+    while (entry != NULL && entry->stats.site != site) {
+        entry = entry->next;
+    }
+    if (entry == NULL && create) {
+        entry = calloc(1, sizeof(struct lock_profile_entry));
+        if (entry != NULL) {
+            entry->stats.site = site;
+            entry->next = lock_profiles[bucket];
+            lock_profiles[bucket] = entry;
+        }
+    }
+    return entry != NULL ? &entry->stats : NULL;
+}
+
+/**
+ * Compter une acquisition du mutex ; start est la date du début de l'attente,
+ * 0 si le mutex était libre
+ */
+static void lock_profile_acquired(thread_mutex_t *mutex, unsigned long start){
+    thread_lock_profile_t *profile = mutex->profile;
+    mutex->since = lock_profile_now();
+    profile->acquisitions++;
+    if (start != 0) {
+        unsigned long wait = mutex->since - start;
+        profile->contended++;
+        profile->wait_total += wait;
+        if (wait > profile->wait_max) {
+            profile->wait_max = wait;
+        }
+    }
+}
+
+/**
+    @fn int thread_lock_profile_enable(int enable)
+    @brief Activer ou désactiver le profilage des mutex initialisés à partir de maintenant
+    @return 0
+ */
+int thread_lock_profile_enable(int enable){
+    lock_profiling = enable != 0;
+    return 0;
+}
+
+/**
+    @fn int thread_lock_profile_get(const thread_mutex_t *mutex, thread_lock_profile_t *profile)
+    @brief Récupérer les statistiques du site d'initialisation d'un mutex
+    @return 0 si réussi, -1 si le mutex n'est pas profilé ou si profile est NULL
+ */
+int thread_lock_profile_get(const thread_mutex_t *mutex, thread_lock_profile_t *profile){
+    if (mutex == NULL || mutex->profile == NULL || profile == NULL) {
+        return -1;
+    }
+    *profile = *mutex->profile;
+    return 0;
+}
+
+/**
+ * Ordre décroissant du temps d'attente cumulé
+ */
+static int lock_profile_compare(const void *a, const void *b){
+    const thread_lock_profile_t *pa = *(thread_lock_profile_t * const *) a;
+    const thread_lock_profile_t *pb = *(thread_lock_profile_t * const *) b;
+    return (pa->wait_total < pb->wait_total) - (pa->wait_total > pb->wait_total);
+}
+
+/**
+    @fn void thread_lock_profile_report(FILE *out)
+    @brief Afficher les statistiques des mutex par site d'initialisation, les plus attendus en premier
+ */
+void thread_lock_profile_report(FILE *out){
+    thread_lock_profile_t **sites;
+    size_t count = 0, i;
+    Dl_info info;
+    for (i = 0; i < LOCK_PROFILE_BUCKETS; i++) {
+        for (struct lock_profile_entry *entry = lock_profiles[i]; entry != NULL; entry = entry->next) {
+            count++;
+        }
+    }
+    fprintf(out, "Contention des mutex par site d'initialisation\n");
+    if (count == 0 || (sites = malloc(count * sizeof(*sites))) == NULL) {
+        return;
+    }
+    count = 0;
+    for (i = 0; i < LOCK_PROFILE_BUCKETS; i++) {
+        for (struct lock_profile_entry *entry = lock_profiles[i]; entry != NULL; entry = entry->next) {
+            sites[count++] = &entry->stats;
+        }
+    }
+    qsort(sites, count, sizeof(*sites), lock_profile_compare);
+    for (i = 0; i < count; i++) {
+        thread_lock_profile_t *site = sites[i];
+        /**
+         * Sans symbole, le site est repéré par son décalage dans son objet (pour addr2line),
+         * ou à défaut par sa seule adresse
+         */
+        int found = dladdr(site->site, &info);
+        if (found && info.dli_sname != NULL) {
+            fprintf(out, "%p (%s+0x%lx)", site->site, info.dli_sname,
+                    (unsigned long) ((uintptr_t) site->site - (uintptr_t) info.dli_saddr));
+        }
+        else if (found && info.dli_fname != NULL) {
+            fprintf(out, "%p (%s+0x%lx)", site->site, info.dli_fname,
+                    (unsigned long) ((uintptr_t) site->site - (uintptr_t) info.dli_fbase));
         }
         else {
-            signal_to_wait_for->handler(signal_to_wait_for->type);
+            fprintf(out, "%p", site->site);
+        }
+        fprintf(out, ": %lu mutex, %lu acquisitions dont %lu avec attente, "
+                "attente %lu ns (max %lu ns), détention %lu ns\n",
+                site->mutexes, site->acquisitions, site->contended,
+                site->wait_total, site->wait_max, site->hold_total);
+    }
+    free(sites);
+}
+
+/**
+ * Lien vers le thread à réveiller : le premier arrivé, ou en ordonnancement par priorité
+ * le plus prioritaire (le premier arrivé à priorité égale). NULL si la file est vide
+ */
+static struct thread **mutex_next_waiter(thread_mutex_t *mutex){
+    struct thread **link = NULL;
+    #ifdef PRIORITY
+    struct thread **it;
+    for (it = &mutex->waiters; *it != NULL; it = &(*it)->wait_next) {
+        if (link == NULL || (*it)->priority > (*link)->priority) {
+            link = it;
+        }
+    }
+    #else
+    if (mutex->waiters != NULL) {
+        link = &mutex->waiters;
+    }
+    #endif
+    return link;
+}
+
+/**
+ * Héritage de priorité : élever owner à priority, puis le détenteur du mutex qu'il attend
+ */
+static void mutex_inherit(struct thread *owner, int priority){
+    #ifdef PRIORITY
+    while (owner != NULL && owner->priority < priority) {
+        if (owner->base_priority < 0) {
+            owner->base_priority = owner->priority;
         }
+        thread_set_effective_priority(owner, priority);
+        owner = owner->wait_mutex != NULL ? MUTEX_OWNER(owner->wait_mutex->word) : NULL;
+    }
+    #else
+    (void) owner;
+    (void) priority;
+    #endif
+}
+
+/**
+ * Bloquer le thread courant, inscrit au préalable dans une file d'attente, jusqu'à ce
+ * que thread_unpark() le rende prêt
+ */
+static void thread_park(struct thread *self){
+    remove_thread_from_queue(self);
+    self->state = THREAD_BLOCKED;
+    current_thread = get_thread();
+    handle_swap(self, current_thread);
+}
+
+/**
+ * Changer la priorité d'un thread, en le déplaçant de niveau dans la file s'il est prêt
+ */
+static void thread_set_effective_priority(struct thread *thread, int priority){
+    assert(priority >= 0 && priority < MAX_PRIORITY);
+    if (thread->state == THREAD_READY) {
+        remove_thread_from_queue(thread);
+        set_thread_priority(thread, priority);
+        add_thread_to_queue_tail(thread);
+    }
+    else {
+        set_thread_priority(thread, priority);
+    }
+}
+
+/************************************
+    Verrous lecteurs-rédacteurs
+*************************************/
+
+/**
+    @fn int thread_rwlock_init(thread_rwlock_t *rwlock, int prefer)
+    @brief Initialiser un verrou lecteurs-rédacteurs libre
+    @param prefer THREAD_RWLOCK_PREFER_READER ou THREAD_RWLOCK_PREFER_WRITER
+    @return 0 si réussi, -1 si rwlock est NULL ou la préférence invalide
+ */
+int thread_rwlock_init(thread_rwlock_t *rwlock, int prefer){
+    if (rwlock == NULL || (prefer != THREAD_RWLOCK_PREFER_READER && prefer != THREAD_RWLOCK_PREFER_WRITER)) {
+        return -1;
+    }
+    memset(rwlock->readers, 0, sizeof(rwlock->readers));
+    rwlock->writer = NULL;
+    rwlock->waiters = NULL;
+    rwlock->writers_waiting = 0;
+    rwlock->prefer = prefer;
+    return 0;
+}
+
+/**
+    @fn int thread_rwlock_destroy(thread_rwlock_t *rwlock)
+    @brief Détruire un verrou lecteurs-rédacteurs
+    @return 0 si réussi, -1 si le verrou est détenu ou attendu
+ */
+int thread_rwlock_destroy(thread_rwlock_t *rwlock){
+    if (rwlock->writer != NULL || rwlock->waiters != NULL || rwlock_readers(rwlock) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+    @fn int thread_rwlock_rdlock(thread_rwlock_t *rwlock)
+    @brief Prendre le verrou en lecture
+    Le lecteur n'écrit que dans l'indicateur de son worker. Il se bloque si un rédacteur détient
+    le verrou, ou en préférence rédacteurs si un rédacteur attend.
+    @return 0 si réussi, EDEADLK si le thread courant détient le verrou en écriture
+ */
+int thread_rwlock_rdlock(thread_rwlock_t *rwlock){
+    disable_interrupt();
+    struct thread *self = current_thread;
+    if (rwlock->writer == NULL
+        && (rwlock->prefer == THREAD_RWLOCK_PREFER_READER || rwlock->writers_waiting == 0)) {
+        rwlock->readers[WORKER_SLOT].count++;
+        enable_interrupt();
         return 0;
     }
-    return -1;
+    if (rwlock->writer == self) {
+        enable_interrupt();
+        return EDEADLK;
+    }
+    rwlock_wait(rwlock, self, 0);
+    enable_interrupt();
+    return 0;
 }
 
-void thread_sigaction_t(int signal, sig_handler new_handler) {
-    if(signal<NBR_SIGNALS && signal >= 0){
-        signal_t * signal_got = get_signal((signal_type)signal);
-        if (signal_got->type == SIG_KILL && new_handler == signal_ignore) {
-            fprintf(stderr, "Signal SIG_KILL can not be ignored\n");
+/**
+    @fn int thread_rwlock_wrlock(thread_rwlock_t *rwlock)
+    @brief Prendre le verrou en écriture, une fois tous les lecteurs sortis
+    @return 0 si réussi, EDEADLK si le thread courant détient déjà le verrou en écriture
+ */
+int thread_rwlock_wrlock(thread_rwlock_t *rwlock){
+    disable_interrupt();
+    struct thread *self = current_thread;
+    if (rwlock->writer == NULL && rwlock_readers(rwlock) == 0) {
+        rwlock->writer = self;
+        enable_interrupt();
+        return 0;
+    }
+    if (rwlock->writer == self) {
+        enable_interrupt();
+        return EDEADLK;
+    }
+    rwlock->writers_waiting++;
+    rwlock_wait(rwlock, self, 1);
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn int thread_rwlock_unlock(thread_rwlock_t *rwlock)
+    @brief Relâcher le verrou, pris en lecture ou en écriture
+    Lorsque le verrou devient libre, il est transmis au premier rédacteur en attente (en tête de
+    la file, ou n'importe où en préférence rédacteurs), sinon à tous les lecteurs en attente.
+    @return 0 si réussi, -1 si le verrou n'est pas détenu
+ */
+int thread_rwlock_unlock(thread_rwlock_t *rwlock){
+    disable_interrupt();
+    if (rwlock->writer == current_thread) {
+        rwlock->writer = NULL;
+    }
+    else if (rwlock->readers[WORKER_SLOT].count > 0) {
+        rwlock->readers[WORKER_SLOT].count--;
+    }
+    else {
+        enable_interrupt();
+        return -1;
+    }
+    if (rwlock->writer == NULL && rwlock_readers(rwlock) == 0) {
+        rwlock_grant(rwlock);
+    }
+    enable_interrupt();
+    return 0;
+}
+
+/**
+ * Nombre de lecteurs, tous workers confondus
+ */
+static unsigned long rwlock_readers(thread_rwlock_t *rwlock){
+    unsigned long count = 0;
+    for (int i = 0; i < THREAD_RWLOCK_SLOTS; i++) {
+        count += rwlock->readers[i].count;
+    }
+    return count;
+}
+
+/**
+ * Se bloquer en fin de file ; rwlock_grant() nous accorde le verrou avant de nous réveiller
+ */
+static void rwlock_wait(thread_rwlock_t *rwlock, struct thread *self, int writer){
+    struct thread **last;
+    for (last = &rwlock->waiters; *last != NULL; last = &(*last)->wait_next) {
+    }
+    self->wait_next = NULL;
+    self->wait_writer = writer;
+    *last = self;
+    thread_park(self);
+}
+
+/**
+ * Accorder le verrou libre aux threads en attente
+ */
+static void rwlock_grant(thread_rwlock_t *rwlock){
+    struct thread **link = &rwlock->waiters, *thread;
+    if (*link == NULL) {
+        return;
+    }
+    if (rwlock->prefer == THREAD_RWLOCK_PREFER_WRITER) {
+        while (*link != NULL && !(*link)->wait_writer) {
+            link = &(*link)->wait_next;
         }
-        else {
-            signal_got->old_handler = signal_got->handler;
-            signal_got->handler = new_handler;
+        if (*link == NULL) {
+            link = &rwlock->waiters;
+        }
+    }
+    if ((*link)->wait_writer) {
+        thread = *link;
+        *link = thread->wait_next;
+        thread->wait_next = NULL;
+        rwlock->writers_waiting--;
+        rwlock->writer = thread;
+        thread_unpark(thread);
+        return;
+    }
+    /**
+     * Aucun rédacteur à servir : tous les lecteurs en attente entrent ensemble
+     */
+    link = &rwlock->waiters;
+    while (*link != NULL) {
+        thread = *link;
+        if (thread->wait_writer) {
+            link = &thread->wait_next;
+            continue;
         }
+        *link = thread->wait_next;
+        thread->wait_next = NULL;
+        rwlock->readers[WORKER_SLOT].count++;
+        thread_unpark(thread);
     }
 }
 
-void signal_ignore(signal_type sig) {
-    printf("Ignoring the signal %d received\n", (int)sig);
+
+
+/************************************
+    Attente sur une adresse
+*************************************/
+
+/**
+ * File d'attente des threads bloqués sur une adresse
+ */
+static struct thread **wait_bucket(const volatile int *addr){
+    return &wait_table[((uintptr_t)addr >> 2) % WAIT_BUCKETS];
+}
+
+/**
+    @fn int thread_wait_on(const volatile int *addr, int expected)
+    @brief Bloquer le thread courant tant que *addr vaut expected, jusqu'à un thread_wake() sur addr
+    @param addr Adresse surveillée
+    @param expected Valeur de *addr pour laquelle le thread se bloque
+    @return 0 après un réveil, EAGAIN si *addr ne valait déjà plus expected.
+    Le réveil ne garantit pas que la valeur ait changé : l'appelant la relit et attend à nouveau
+ */
+int thread_wait_on(const volatile int *addr, int expected){
+    struct thread *self = current_thread, **last;
+    /**
+     * La comparaison et l'inscription dans la file sont faites sans préemption : un
+     * thread_wake() qui suit la modification de *addr ne peut pas passer entre les deux
+     */
+    disable_interrupt();
+    if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != expected) {
+        enable_interrupt();
+        return EAGAIN;
+    }
+    for (last = wait_bucket(addr); *last != NULL; last = &(*last)->wait_next) {
+    }
+    self->wait_next = NULL;
+    self->wait_addr = addr;
+    *last = self;
+    thread_park(self);
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn int thread_wake(const volatile int *addr, int n)
+    @brief Réveiller, dans l'ordre d'arrivée, au plus n threads bloqués sur addr
+    @param addr Adresse surveillée
+    @param n Nombre maximal de threads à réveiller, THREAD_WAKE_ALL pour tous
+    @return Nombre de threads réveillés
+ */
+int thread_wake(const volatile int *addr, int n){
+    struct thread **link, *thread;
+    int woken = 0;
+    disable_interrupt();
+    link = wait_bucket(addr);
+    while (*link != NULL && (n < 0 || woken < n)) {
+        thread = *link;
+        if (thread->wait_addr != addr) {
+            link = &thread->wait_next;
+            continue;
+        }
+        *link = thread->wait_next;
+        thread->wait_next = NULL;
+        thread->wait_addr = NULL;
+        thread_unpark(thread);
+        woken++;
+    }
+    enable_interrupt();
+    return woken;
+}
+
+/************************************
+    Implementation des Sémaphores 
+*************************************/
+
+/**
+ *  @struct thread_sem
+ *  @brief Structure de notre sémaphore
+ */
+struct thread_sem{
+    int value;          /*!<Nombre actuel de ressources, adresse d'attente des threads bloqués*/
+    int max_resources;  /*!<Nombre maximal de ressources*/
+    int waiters;        /*!<Nombre de threads bloqués ou en train de se bloquer sur value*/
+    int destroyed;      /*!<Indicateur de destruction*/
+};
+
+/**
+    @fn int thread_sem_init(thread_sem_t *sem, int pshared, unsigned int value)
+    @brief Fonction d'initialisation de notre sémaphore
+    @param sem Pointeur vers la sémaphore à initialiser
+    @param pshared Ignoré (toujours égal à zéro)
+    @param value Valeur initiale de la sémaphore
+    @return int 0 si l'initialisation a réussi, -1 sinon 
+ */
+int thread_sem_init(thread_sem_t *sem, int pshared, unsigned int value){
+
+    /**
+    * allocation de la mémoire allouée à la sémaphore 
+    */ 
+    *sem = malloc(sizeof(struct thread_sem));
+
+    assert(pshared==0);
+    if(*sem == NULL){
+        return -1;
+    }
+    /**
+     * initialisation des champs de la sémaphore
+     */
+    (*sem)->value = value;
+    (*sem)->max_resources = value;
+    (*sem)->waiters = 0;
+    (*sem)->destroyed = 0;
+    mem_stats.sync += sizeof(struct thread_sem);
+    return 0;
+}
+
+/**
+    @fn int thread_sem_destroy(thread_sem_t *sem)
+    @brief fonction de destruction de notre sémaphore
+    @param sem Pointeur vers la sémaphore à détruire
+    @return int 0 si la destruction a réussi, -1 sinon 
+ */
+int thread_sem_destroy(thread_sem_t *sem){
+    struct thread_sem *s = *sem;
+    int value;
+    __atomic_store_n(&s->destroyed, 1, __ATOMIC_RELEASE);
+    /**
+     * Les threads en attente sont réveillés et renvoient -1 ; on attend qu'ils aient
+     * quitté la sémaphore, puis que toutes les ressources prises aient été rendues
+     */
+    thread_wake(&s->value, THREAD_WAKE_ALL);
+    while ((value = __atomic_load_n(&s->waiters, __ATOMIC_ACQUIRE)) > 0) {
+        thread_wait_on(&s->waiters, value);
+    }
+    while ((value = __atomic_load_n(&s->value, __ATOMIC_ACQUIRE)) < s->max_resources) {
+        thread_wait_on(&s->value, value);
+    }
+    free(s);
+    mem_stats.sync -= sizeof(struct thread_sem);
+    return 0;
+}
+
+/**
+    @fn int thread_sem_wait(thread_sem_t sem)
+    @brief Fonction d'attente d'un thread sur une sémaphore
+    @param sem Sémaphore sur laquelle le thread attend
+    @return int 0 si le thread a réussi à acquérir la ressource, -1 si la sémaphore a été détruite
+ */
+int thread_sem_wait(thread_sem_t sem) {
+    int value, destroyed;
+    for (;;) {
+        /**
+         * S'il reste une ressource, on la prend
+         */
+        value = __atomic_load_n(&sem->value, __ATOMIC_ACQUIRE);
+        if (value > 0) {
+            if (__atomic_compare_exchange_n(&sem->value, &value, value - 1, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                return 0;
+            }
+            continue;
+        }
+        if (__atomic_load_n(&sem->destroyed, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        /**
+         * Sinon on se bloque tant qu'aucune ressource n'est rendue. waiters est compté
+         * avant de relire value : thread_sem_post() voit alors qu'il doit nous réveiller
+         */
+        __atomic_fetch_add(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+        thread_wait_on(&sem->value, 0);
+        destroyed = __atomic_load_n(&sem->destroyed, __ATOMIC_ACQUIRE);
+        if (__atomic_sub_fetch(&sem->waiters, 1, __ATOMIC_RELEASE) == 0 && destroyed) {
+            thread_wake(&sem->waiters, THREAD_WAKE_ALL);
+        }
+        if (destroyed) {
+            return -1;
+        }
+    }
+}
+
+/**
+    @fn int thread_sem_post(thread_sem_t sem)
+    @brief Fonction d'incrémentation du sémaphore
+    @param sem Sémaphore à incrémenter
+    @return int 0 si l'incrémentation a réussi, -1 sinon
+ */
+int thread_sem_post(thread_sem_t sem){
+    int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+    /**
+     * Le nombre de ressources courantes ne dépasse pas le nombre de ressources maximales
+     */
+    do {
+        if (value >= sem->max_resources) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&sem->value, &value, value + 1, 0,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    /**
+     * Un thread bloqué est réveillé, ou thread_sem_destroy() qui attend les ressources
+     */
+    if (__atomic_load_n(&sem->waiters, __ATOMIC_SEQ_CST) > 0
+        || __atomic_load_n(&sem->destroyed, __ATOMIC_ACQUIRE)) {
+        thread_wake(&sem->value, 1);
+    }
+    return 0;
+}
+
+/************************************
+    Implementation des Barrières
+*************************************/
+
+/**
+    @struct thread_barrier
+    @brief Structure de nos barrières
+ */
+struct thread_barrier{
+    int count;          /*!<Nombre total de threads devant atteindre la barrière */
+    int waiting;        /*!<Nombre de threads arrivés à la barrière pour le passage courant*/
+    int generation;     /*!<Numéro du passage courant, adresse d'attente des threads arrivés*/
+};
+
+/**
+    @fn int thread_barrier_init(thread_barrier_t *barrier, unsigned int count)
+    @brief fonction d'initialisation de notre structure de barrière
+    @brief Initialise une barrière avec un nombre donné de threads attendus
+    @param barrier Pointeur vers la structure de barrière à initialiser
+    @param count Nombre total de threads devant atteindre la barrière
+    @return 0 si l'initialisation a réussi, -1 sinon 
+ */
+int thread_barrier_init(thread_barrier_t *barrier, unsigned int count){
+    /**
+     *  On s'assure que count est strictement positif
+     *  Car on ne peut attendre un nombre négatif ou zéro thread 
+     */
+    if (count <= 0) {
+        return -1;
+    }
+    /**
+     * on initialise les champs de notre barrier 
+     */
+    *barrier = malloc(sizeof(struct thread_barrier));
+    if (*barrier == NULL) {
+        return -1;
+    }
+    (*barrier)->count = count;
+    (*barrier)->waiting = 0;
+    (*barrier)->generation = 0;
+    mem_stats.sync += sizeof(struct thread_barrier);
+    return 0;
+}
+
+/**
+    @fn int thread_barrier_wait(thread_barrier_t barrier)
+    @brief fonction d'attente sur une barrier
+    @brief Attend sur la barrière jusqu'à ce que tous les threads attendus aient atteint la barrière
+    @param barrier Structure de barrière à attendre
+    @return 0 si tous les threads attendus ont atteint la barrière
+ */
+int thread_barrier_wait(thread_barrier_t barrier){
+    int generation = __atomic_load_n(&barrier->generation, __ATOMIC_ACQUIRE);
+
+    /**
+     * Le dernier thread arrivé remet le compteur à zéro pour le passage suivant,
+     * puis ouvre la barrière en changeant de passage
+     */
+    if (__atomic_add_fetch(&barrier->waiting, 1, __ATOMIC_ACQ_REL) == barrier->count) {
+        __atomic_store_n(&barrier->waiting, 0, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&barrier->generation, 1, __ATOMIC_RELEASE);
+        thread_wake(&barrier->generation, THREAD_WAKE_ALL);
+        return 0;
+    }
+    /**
+     * Sinon on se bloque jusqu'au changement de passage
+     */
+    while (__atomic_load_n(&barrier->generation, __ATOMIC_ACQUIRE) == generation) {
+        thread_wait_on(&barrier->generation, generation);
+    }
+    return 0;
+}
+
+/**
+    @fn int thread_barrier_destroy(thread_barrier_t *barrier)
+    @brief Détruit une barrière et libère les ressources associées
+    @param barrier Pointeur vers la structure de barrière à détruire
+    @return 0 si la destruction a réussi, -1 sinon
+ */
+int thread_barrier_destroy(thread_barrier_t *barrier){
+    free(*barrier);
+    mem_stats.sync -= sizeof(struct thread_barrier);
+    return 0;
+}
+
+/************************************
+    Implementation des thread_cond
+*************************************/
+
+/**
+    @struct thread_cond
+    @brief Structure pour une condition de thread
+*/
+struct thread_cond {
+    TAILQ_HEAD(cond_queue, thread) queue_cond; /*!<File d'attente de threads en attente de la condition*/
+};
+
+/**
+    @fn int thread_cond_init(thread_cond_t *cond)
+    @brief Initialise la condition spécifiée
+    @param cond Pointeur vers la condition à initialiser
+    @return 0 si réussi, -1 si une erreur est survenue
+    Cette fonction alloue de la mémoire pour la condition spécifiée et initialise ses champs, y compris sa file d'attente.
+*/
+int thread_cond_init(thread_cond_t *cond) {
+    /**
+     * Allocation de la mémoire pour la condition 
+     */
+    *cond = malloc(sizeof(struct thread_cond));
+    if (*cond == NULL) {
+        return -1;
+    }
+    /**
+     * initialisation des champs de la condition
+     */
+    TAILQ_INIT(&((*cond)->queue_cond));
+    mem_stats.sync += sizeof(struct thread_cond);
+    return 0;
+}
+
+/**
+    @brief Attend la condition spécifiée
+    @param cond Condition à attendre
+    @param mutex Verrou à utiliser pour la synchronisation
+    @return 0 si réussi, -1 si une erreur est survenue
+    Cette fonction ajoute le thread courant à la file d'attente de la condition, relâche le verrou, suspend le thread courant, puis acquiert à nouveau le verrou.
+*/
+int thread_cond_wait(thread_cond_t cond, thread_mutex_t *mutex) {
+    /**
+    * Vérifie que les arguments sont bien définis 
+    */
+    if (cond == NULL || mutex == NULL) {
+        return -1;
+    }
+    disable_interrupt();
+    struct thread *self = current_thread;
+
+    /**
+     * Relâcher le verrou puis quitter la file des threads prêts avant d'entrer dans
+     * celle de la condition : les deux files partagent le même chaînage
+     */
+    thread_mutex_unlock(mutex);
+    remove_thread_from_queue(self);
+    self->state = THREAD_BLOCKED;
+    update_thread_priority(self);
+    TAILQ_INSERT_TAIL(&(cond->queue_cond), self, threads);
+    current_thread = get_thread();
+    handle_swap(self, current_thread);
+
+    /**
+     * Réveillé par thread_cond_signal() ou thread_cond_broadcast(), qui l'ont retiré
+     * de la file de la condition : acquérir à nouveau le verrou
+     */
+    thread_mutex_lock(mutex);
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn int thread_cond_signal(thread_cond_t cond)
+    @brief Signale un thread en attente de la condition spécifiée
+    @param cond Condition à signaler
+    @return 0 si réussi, -1 si une erreur est survenue
+    Cette fonction récupère le premier thread en attente de la condition spécifiée et le remet dans la queue de threads prêts.
+*/
+int thread_cond_signal(thread_cond_t cond) {
+    if (cond == NULL) {
+        return -1;
+    }
+    disable_interrupt();
+    /**
+     * Récupérer le premier thread de la file d'attente de la condition
+     */
+    thread_t thread = TAILQ_FIRST(&(cond->queue_cond));
+
+    if (thread != NULL) {
+        /**
+         * Si la file d'attente n'est pas vide, retirer le premier thread et le remettre dans la queue de threads prêts
+         */
+        TAILQ_REMOVE(&(cond->queue_cond), thread, threads);
+        thread_unpark(thread);
+    }
+    enable_interrupt();
+
+    return 0;
+}
+
+/**
+    @fn int thread_cond_broadcast(thread_cond_t cond)
+    @brief Signale tous les threads en attente de la condition spécifiée
+    @param cond Condition à signaler
+    @return 0 si réussi, -1 si une erreur est survenue
+    Cette fonction récupère tous les threads en attente de la condition spécifiée et les remet dans la queue de threads prêts.
+*/
+int thread_cond_broadcast(thread_cond_t cond) {
+    if (cond == NULL) {
+        return -1;
+    }
+    disable_interrupt();
+    /**
+     * Pour chaque thread de la file d'attente de la condition, le retirer et le remettre dans la queue de threads prêts
+     */
+    while (!TAILQ_EMPTY(&(cond->queue_cond))) {
+        thread_t thread = TAILQ_FIRST(&(cond->queue_cond));
+        TAILQ_REMOVE(&(cond->queue_cond), thread, threads);
+        thread_unpark(thread);
+    }
+    enable_interrupt();
+
+    return 0;
+}
+
+/**
+    @fn int thread_cond_destroy(thread_cond_t *cond)
+    @brief Détruit la condition spécifiée
+    @param cond Pointeur vers la condition à détruire
+    @return 0 si réussi, -1 si une erreur est survenue
+    Cette fonction libère la mémoire allouée pour la condition spécifiée.
+*/
+int thread_cond_destroy(thread_cond_t *cond) {
+    if (cond == NULL || *cond == NULL) {
+        return -1;
+    }
+
+    free(*cond);
+    *cond = NULL;
+    mem_stats.sync -= sizeof(struct thread_cond);
+
+    return 0;
+}
+
+/************************************
+    Préemption
+*************************************/
+
+/**
+    @fn int thread_set_timeslice(thread_t thread, unsigned long usec)
+    @brief Changer la tranche de temps par défaut (thread NULL) ou celle d'un thread
+    La nouvelle tranche prend effet au prochain changement de contexte, ou tout de suite
+    si elle concerne le thread courant.
+    @param usec Tranche de temps en microsecondes ; 0 rend au thread la tranche par défaut
+    @return 0 si réussi, -1 si la tranche est inférieure à THREAD_TIMESLICE_MIN
+ */
+int thread_set_timeslice(thread_t thread, unsigned long usec){
+    if ((usec != 0 || thread == NULL) && usec < THREAD_TIMESLICE_MIN) {
+        return -1;
+    }
+    if (thread == NULL) {
+        timeslice = usec;
+    }
+    else {
+        thread->timeslice = usec;
+    }
+    disable_interrupt();
+    preempt_timer_update(current_thread);
+    enable_interrupt();
+    return 0;
+}
+
+/**
+    @fn unsigned long thread_get_timeslice(thread_t thread)
+    @brief Tranche de temps par défaut (thread NULL) ou effective d'un thread, en microsecondes
+ */
+unsigned long thread_get_timeslice(thread_t thread){
+    return thread_slice(thread);
+}
+
+/**
+    @fn int thread_sched_adaptive_enable(int enable)
+    @brief Activer ou désactiver l'ajustement des tranches d'après le comportement des threads
+    @return 0
+ */
+int thread_sched_adaptive_enable(int enable){
+    sched_adaptive = enable != 0;
+    return 0;
+}
+
+/**
+    @fn int thread_get_sched_class(thread_t thread)
+    @brief Classe observée d'un thread
+    @return THREAD_SCHED_INTERACTIVE, THREAD_SCHED_CPU ou THREAD_SCHED_NORMAL
+ */
+int thread_get_sched_class(thread_t thread){
+    if (thread == NULL || (thread->sched_score > -SCHED_SCORE_CLASS && thread->sched_score < SCHED_SCORE_CLASS)) {
+        return THREAD_SCHED_NORMAL;
+    }
+    return thread->sched_score > 0 ? THREAD_SCHED_INTERACTIVE : THREAD_SCHED_CPU;
+}
+
+/**
+    @fn int thread_set_preempt_mode(int mode)
+    @brief Choisir comment le timer signale la fin d'une tranche
+    Le timer du worker est recréé avec la nouvelle notification, puis réarmé si nécessaire.
+    @param mode THREAD_PREEMPT_SIGNAL ou THREAD_PREEMPT_COOPERATIVE
+    @return 0 si réussi, -1 si le mode est invalide, sans préemption ou si le timer n'a pu être créé
+ */
+int thread_set_preempt_mode(int mode){
+    #ifdef PREEMPTION
+    timer_t timer;
+    if (mode != THREAD_PREEMPT_SIGNAL && mode != THREAD_PREEMPT_COOPERATIVE) {
+        return -1;
+    }
+    if (mode == worker.preempt_mode) {
+        return 0;
+    }
+    disable_interrupt();
+    if (preempt_timer_create(mode, &timer) != 0) {
+        enable_interrupt();
+        return -1;
+    }
+    timer_delete(worker.timer);
+    worker.timer = timer;
+    worker.timer_slice = 0;
+    worker.preempt_mode = mode;
+    thread_resched = 0;
+    preempt_timer_update(current_thread);
+    enable_interrupt();
+    return 0;
+    #else
+    (void) mode;
+    return -1;
+    #endif
+}
+
+/**
+    @fn void thread_preempt_point(void)
+    @brief Point sûr : céder le processeur comme sur préemption
+    Appelée par thread_maybe_yield() lorsque thread_resched est levé. En section critique,
+    le changement de thread est différé jusqu'à la sortie de la dernière.
+ */
+void thread_preempt_point(void){
+    thread_resched = 0;
+    #ifdef PREEMPTION
+    if (worker.preempt_count > 0) {
+        worker.preempt_pending = 1;
+        return;
+    }
+    preempt();
+    #endif
+}
+
+/**
+    @fn int thread_get_sched_stats(thread_sched_stats_t *stats)
+    @brief Récupérer les compteurs de l'ordonnanceur
+    @return 0 si réussi, -1 si stats est NULL
+ */
+int thread_get_sched_stats(thread_sched_stats_t *stats){
+    if (stats == NULL) {
+        return -1;
+    }
+    *stats = sched_stats;
+    stats->timeslice = worker.timer_slice;
+    return 0;
+}
+
+/************************************
+    Consommation mémoire
+*************************************/
+
+/**
+    @fn int thread_get_mem_stats(thread_mem_stats_t *stats)
+    @brief Récupérer la consommation mémoire courante de la bibliothèque
+    @param stats Structure remplie avec la mémoire réservée par catégorie
+    @return 0 si réussi, -1 si stats est NULL
+ */
+int thread_get_mem_stats(thread_mem_stats_t *stats){
+    if (stats == NULL) {
+        return -1;
+    }
+    *stats = mem_stats;
+    return 0;
+}
+
+/*******************************  
+    Implementation Signaux 
+********************************/
+
+int thread_kill(thread_t *thread, int signal){
+    if(signal<NBR_SIGNALS && signal >= 0){
+        signal_t * signal_to_send = get_signal((signal_type)signal);
+        if(get_thread_current_signal(thread)<MAX_SIGNALS-1){
+            int index = get_thread_current_signal(thread);
+            set_thread_signal_array(thread,index,signal_to_send);
+            printf("thread %d sends %s signal to thread %d\n",current_thread->id,signal_enum_to_string(signal),(*thread)->id);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int thread_signal_wait(int signal) {
+    if(signal<NBR_SIGNALS && signal >= 0){
+        signal_t * signal_to_wait_for = get_signal((signal_type)signal);
+        if (current_thread->th == NULL) {
+            return 0;
+        }
+        int index = current_thread->th->current_signal-1;
+        while(current_thread->th->signal_array[index] != signal_to_wait_for){
+            thread_yield();
+        }
+        if (signal_to_wait_for->handler == NULL) {
+            default_signal_handler(signal_to_wait_for->type);
+        }
+        else {
+            signal_to_wait_for->handler(signal_to_wait_for->type);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int thread_signal_timed_wait(int signal, int timeout) {
+    if(signal<NBR_SIGNALS && signal >= 0){
+        signal_t * signal_to_wait_for = get_signal((signal_type)signal);
+        if (current_thread->th == NULL) {
+            return -1;
+        }
+        int i = 0;
+        int index = current_thread->th->current_signal -1;
+        while(current_thread->th->signal_array[index] != signal_to_wait_for){
+            thread_yield();
+            i++;
+            if(i>timeout){
+                break;
+            }
+        }
+        if (signal_to_wait_for->handler == NULL) {
+            default_signal_handler(signal_to_wait_for->type);
+        }
+        else {
+            signal_to_wait_for->handler(signal_to_wait_for->type);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+void thread_sigaction_t(int signal, sig_handler new_handler) {
+    if(signal<NBR_SIGNALS && signal >= 0){
+        signal_t * signal_got = get_signal((signal_type)signal);
+        if (signal_got->type == SIG_KILL && new_handler == signal_ignore) {
+            fprintf(stderr, "Signal SIG_KILL can not be ignored\n");
+        }
+        else {
+            signal_got->old_handler = signal_got->handler;
+            signal_got->handler = new_handler;
+        }
+    }
+}
+
+void signal_ignore(signal_type sig) {
+    printf("Ignoring the signal %d received\n", (int)sig);
+}
+
+signal_t *get_signal (signal_type type) {
+    switch (type){
+    case SIG_USER1 :
+        return &signals[0];
+        break;
+    case SIG_USER2 :
+        return &signals[1];
+        break;
+    case SIG_KILL :
+        return &signals[3];
+        break;
+    default:
+        return &no_signal;
+        break;
+    }
+}
+
+int  get_thread_current_signal(thread_t *thread) {
+    return (*thread)->th->current_signal;
+}
+
+void set_thread_signal_array(thread_t *thread, int index, signal_t *signal){
+    (*thread)->th->signal_array[index] = signal;
+    (*thread)->th->current_signal = index+1;
+}
+
+void thread_signal_init(thread_signal_t *th){
+    if(th != NULL){
+        int i = 0;
+        for (i=0; i<MAX_SIGNALS; i++){
+            th->signal_array[i] = &no_signal;
+        }
+        th->current_signal = 0;
+    }
+}
+
+int thread_signal_free(thread_signal_t *th){
+  if(th != NULL){
+    free(th);
+    return 0;
+  }
+  return -1;
+}
+
+void default_signal_handler(signal_type sig) {
+    switch (sig){
+    case SIG_KILL:
+        printf("thread %d receives signal SIG_KILL \n", current_thread->id);
+        thread_exit(NULL);
+        break;
+    case SIG_USER1 :
+        printf("thread %d receives SIG_USER1 \n",current_thread->id);
+        break;
+    case SIG_USER2 :
+        printf("thread %d receives SIG_USER2 \n",current_thread->id);
+        break;
+    default:
+        break;
+    }
+  
+}
+
+char * signal_enum_to_string(int signal){
+    switch(signal){
+        case SIG_USER1: return "SIG_USER1"; break;
+        case SIG_USER2: return "SIG_USER2"; break;
+        case SIG_KILL : return "SIG_KILL"; break;
+        default: return "unknown"; break;
+    }
+}
+/*******************************  
+    Side Function Implementation 
+********************************/
+
+/**
+ * Fonction d'initialisation de notre librairie
+ */
+void initializer(void){
+    char *watermark = getenv("THREAD_STACK_WATERMARK");
+    if (watermark != NULL) {
+        thread_set_stack_watermark(strtoul(watermark, NULL, 0));
+    }
+    if (getenv("THREAD_LOCK_PROFILE") != NULL) {
+        thread_lock_profile_enable(atoi(getenv("THREAD_LOCK_PROFILE")));
+    }
+    if (getenv("THREAD_STACK_PROFILE") != NULL) {
+        thread_stack_profile_enable(atoi(getenv("THREAD_STACK_PROFILE")));
+    }
+    if (getenv("THREAD_STACK_AUTOTUNE") != NULL) {
+        thread_stack_autotune_enable(atoi(getenv("THREAD_STACK_AUTOTUNE")));
+    }
+    main_stack_init();
+    queue_init();
+    STAILQ_INIT(&worker.tasks);
+    worker.sched_stack = mmap(NULL, SCHED_STACK_SIZE, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    /**
+     * Sans pile d'ordonnanceur, les changements de contexte avec appel ne peuvent pas
+     * s'exécuter : on s'arrête avant de créer le thread principal
+     */
+    if (worker.sched_stack == MAP_FAILED) {
+        worker.sched_stack = NULL;
+        printf("Erreur lors de l'initialisation de la pile de l'ordonnanceur\n");
+        fflush(stdout);
+        exit(EXIT_FAILURE);
+    }
+    main_thread = thread_init(NULL);
+    current_thread = main_thread;
+    add_thread_to_queue_tail(main_thread);
+    number_thread++;
+    #ifdef PREEMPTION
+    install_handler();
+    #ifdef PREEMPTION
+    init_timer(TIMESLICE);
+    if (getenv("THREAD_TIMESLICE") != NULL) {
+        thread_set_timeslice(NULL, strtoul(getenv("THREAD_TIMESLICE"), NULL, 0));
+    }
+    if (getenv("THREAD_ADAPTIVE") != NULL) {
+        thread_sched_adaptive_enable(atoi(getenv("THREAD_ADAPTIVE")));
+    }
+    if (getenv("THREAD_PREEMPT") != NULL && strcmp(getenv("THREAD_PREEMPT"), "cooperative") == 0) {
+        thread_set_preempt_mode(THREAD_PREEMPT_COOPERATIVE);
+    }
+    #endif
+    #ifdef RR
+    init_timer(main_thread->time_slice);
+    #endif
+    #endif
+}
+
+/**
+ * Fonction de libération de notre librairie
+ */
+void cleaner(void){
+    if (stack_profiling) {
+        thread_stack_profile_report(stderr);
+    }
+    /**
+     * Les entrées du profil des verrous restent allouées : des mutex encore
+     * utilisables après cleaner() pointent toujours vers elles
+     */
+    if (lock_profiling) {
+        thread_lock_profile_report(stderr);
+        lock_profiling = 0;
+    }
+    for (int i = 0; i < STACK_PROFILE_BUCKETS; i++) {
+        while (stack_profiles[i] != NULL) {
+            struct stack_profile_entry *entry = stack_profiles[i];
+            stack_profiles[i] = entry->next;
+            free(entry);
+        }
+    }
+    if(main_thread!=NULL){
+        thread_free(main_thread);
+    }
+    while (descriptor_pool != NULL) {
+        struct thread *thread = descriptor_pool;
+        descriptor_pool = TAILQ_NEXT(thread, threads);
+        thread_signal_free(thread->th);
+        free(thread);
+    }
+    for (int i = 0; i < NB_STACK_CLASSES; i++) {
+        while (stack_pools[i].free != NULL) {
+            stack_release(stack_pop(i), i);
+        }
+    }
+    if (worker.shared_stack != NULL) {
+        munmap(worker.shared_stack, SHARED_STACK_SIZE);
+    }
+    if (worker.sched_stack != NULL) {
+        munmap(worker.sched_stack, SCHED_STACK_SIZE);
+    }
+    #ifdef PREEMPTION
+    timer_delete(worker.timer);
+    #endif
+}
+
+
+#ifdef STACKOVERFLOW
+/**
+ * Fonction de gestion de segfault
+ */
+void segfault_handler(int sig, siginfo_t *si, void *unused) {
+    (void) unused;
+    (void) si;
+    (void) sig;
+    printf("segfault_handler\n");
+    
+    if(current_thread == main_thread){
+        printf("Main segfaulted\n");
+        _exit(1);
+    }
+    else {
+        printf("Signal SIGSEGV (segfault) reçu in %p.\n", current_thread);
+        printf("Adresse mémoire problématique : %p\n", si->si_addr);
+        thread_exit(NULL);
+    }
+
+}
+
+char sp[SIGNAL_STACK_SIZE];
+#endif 
+/*******************************
+    Gestion des piles
+********************************/
+
+/**
+ * Classe de taille correspondant à une taille de pile demandée (0 pour la taille par défaut)
+ */
+static int stack_class(size_t size){
+    int class = 0;
+    if (size == 0) {
+        size = CONTEXT_STACK_SIZE;
+    }
+    while (class < NB_STACK_CLASSES - 1 && STACK_CLASS_SIZE(class) < size) {
+        class++;
+    }
+    return class;
+}
+
+/**
+ * Emplacement du chaînage d'une pile libre
+ */
+static inline void **stack_link(void *stack, int class){
+    return (void **)(stack + STACK_CLASS_SIZE(class)) - 1;
+}
+
+/**
+ * Ajouter une pile libre à la réserve de sa classe
+ */
+static void stack_push(void *stack, int class){
+    *stack_link(stack, class) = stack_pools[class].free;
+    stack_pools[class].free = stack;
+    stack_pools[class].count++;
+    mem_stats.stacks_cached += STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE;
+}
+
+/**
+ * Retirer une pile de la réserve de sa classe
+ */
+static void *stack_pop(int class){
+    void *stack = stack_pools[class].free;
+    stack_pools[class].free = *stack_link(stack, class);
+    stack_pools[class].count--;
+    mem_stats.stacks_cached -= STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE;
+    return stack;
+}
+
+/**
+ * Rendre définitivement la mémoire d'une pile au système
+ */
+static void stack_release(void *stack, int class){
+    munmap(stack - STACK_GUARD_SIZE, STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE);
+}
+
+/**
+ * Obtenir une pile de la classe donnée, depuis la réserve si possible.
+ * Les piles sont réservées avec mmap(MAP_NORESERVE) : seules les pages effectivement
+ * touchées par le thread consomment de la mémoire physique.
+ * Renvoie l'adresse basse utilisable de la pile (au-dessus de la page de garde), NULL en cas d'erreur.
+ */
+static void *stack_alloc(int class){
+    void *stack;
+    if (stack_pools[class].free != NULL) {
+        stack = stack_pop(class);
+    }
+    else {
+        stack = mmap(NULL, STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (stack == MAP_FAILED) {
+            printf("Erreur lors de l'initialisation de la stack du thread\n");
+            fflush(stdout);
+            return NULL;
+        }
+        #ifdef STACKOVERFLOW
+        if (mprotect(stack, PAGE_SIZE, PROT_NONE) != 0) {
+            printf("Erreur lors de la protection en écriture et en lecture de la fin de la pile\n");
+            munmap(stack, STACK_CLASS_SIZE(class) + PAGE_SIZE);
+            return NULL;
+        }
+        #endif
+        stack += STACK_GUARD_SIZE;
+    }
+    mem_stats.stacks += STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE;
+    return stack;
+}
+
+/**
+ * Rendre une pile à la réserve de sa classe, ou au système si la réserve est pleine.
+ * La page de garde reste protégée tant que la pile est dans la réserve.
+ * Les pages situées sous le seuil stack_watermark (compté depuis le haut de la pile)
+ * sont rendues au système avec MADV_DONTNEED : une pile recyclée après une récursion
+ * profonde ne garde résidents que ses premiers octets.
+ */
+static void stack_free(void *stack, int class){
+    size_t size = STACK_CLASS_SIZE(class);
+    mem_stats.stacks -= size + STACK_GUARD_SIZE;
+    if (stack_pools[class].count >= STACK_POOL_MAX) {
+        stack_release(stack, class);
+        return;
+    }
+    if (size > stack_watermark) {
+        madvise(stack, size - stack_watermark, MADV_DONTNEED);
+    }
+    stack_push(stack, class);
+}
+
+/**
+ * Compléter la réserve d'une classe pour qu'elle contienne au moins count piles.
+ * Les piles manquantes sont réservées par un seul appel à mmap puis découpées ;
+ * chacune reste libérable individuellement (munmap d'une partie du bloc).
+ * En cas d'échec, stack_alloc() réessaiera pile par pile.
+ */
+static void stack_reserve(int class, int count){
+    size_t size = STACK_CLASS_SIZE(class) + STACK_GUARD_SIZE;
+    int i, missing = count - stack_pools[class].count;
+    void *block, *stack;
+    if (missing <= 1) {
+        return;
+    }
+    block = mmap(NULL, missing * size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (block == MAP_FAILED) {
+        return;
+    }
+    for (i = 0; i < missing; i++) {
+        stack = block + i * size;
+        #ifdef STACKOVERFLOW
+        if (mprotect(stack, PAGE_SIZE, PROT_NONE) != 0) {
+            munmap(stack, size);
+            continue;
+        }
+        #endif
+        stack_push(stack + STACK_GUARD_SIZE, class);
+    }
+}
+
+/**
+ * Obtenir un descripteur de thread, depuis la réserve si possible
+ */
+static struct thread *descriptor_alloc(void){
+    struct thread *thread = descriptor_pool;
+    if (thread != NULL) {
+        descriptor_pool = TAILQ_NEXT(thread, threads);
+        descriptor_pool_count--;
+        mem_stats.descriptors_cached -= DESCRIPTOR_SIZE;
+    }
+    else {
+        thread = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct thread));
+        if (thread == NULL) {
+            return NULL;
+        }
+        thread->th = malloc(sizeof(thread_signal_t));
+        if (thread->th == NULL) {
+            free(thread);
+            return NULL;
+        }
+    }
+    mem_stats.descriptors += DESCRIPTOR_SIZE;
+    return thread;
+}
+
+/**
+ * Rendre un descripteur à la réserve, ou au système si la réserve est pleine
+ */
+static void descriptor_free(struct thread *thread){
+    mem_stats.descriptors -= DESCRIPTOR_SIZE;
+    if (descriptor_pool_count >= DESCRIPTOR_POOL_MAX) {
+        thread_signal_free(thread->th);
+        free(thread);
+        return;
+    }
+    TAILQ_NEXT(thread, threads) = descriptor_pool;
+    descriptor_pool = thread;
+    descriptor_pool_count++;
+    mem_stats.descriptors_cached += DESCRIPTOR_SIZE;
+}
+
+/**
+ * Libérer un thread terminé : sa pile et son descripteur retournent à leurs réserves
+ */
+static void thread_free(struct thread *thread){
+    if (thread->stack_class < 0) {
+        if (worker.shared_owner == thread) {
+            worker.shared_owner = NULL;
+        }
+        free(thread->saved_stack);
+        mem_stats.stacks -= thread->saved_capacity;
+    }
+    else {
+        VALGRIND_STACK_DEREGISTER(thread->valgrind_stackid);
+        stack_free(thread->stack, thread->stack_class);
+    }
+    if (thread->specific != thread->specific_inline) {
+        free(thread->specific);
+    }
+    descriptor_free(thread);
+    mem_stats.nb_threads--;
+}
+
+/*******************************
+    Pile partagée
+********************************/
+
+/**
+ * Réserver la pile partagée du worker lors de la création du premier thread qui l'utilise
+ */
+static int shared_stack_init(void){
+    if (worker.shared_stack != NULL) {
+        return 0;
+    }
+    void *stack = mmap(NULL, SHARED_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        return -1;
+    }
+    worker.shared_stack = stack;
+    (void) VALGRIND_STACK_REGISTER(stack, stack + SHARED_STACK_SIZE);
+    mem_stats.stacks += SHARED_STACK_SIZE;
+    return 0;
+}
+
+/**
+ * Pointeur de pile sauvegardé dans un contexte
+ */
+static void *context_stack_pointer(struct thread_context *ctx){
+    #if defined(__x86_64__)
+    return ctx->rsp;
+    #else
+    return ctx->sp;
+    #endif
+}
+
+/**
+ * Hook exécuté sur la pile de l'ordonnanceur avant de reprendre un thread en mode pile partagée :
+ * la partie vivante de la pile de l'occupant courant est copiée dans son tampon (sauf s'il est terminé),
+ * puis celle du thread entrant est recopiée en haut de la pile partagée.
+ */
+static struct thread_context *shared_stack_exchange(void *arg){
+    struct thread *next = arg;
+    struct thread *owner = worker.shared_owner;
+    void *top = worker.shared_stack + SHARED_STACK_SIZE;
+
+    if (owner != NULL && owner->state != THREAD_DONE) {
+        size_t size = top - context_stack_pointer(&owner->ctx);
+        if (size > owner->saved_capacity || size < owner->saved_capacity / 2) {
+            void *buffer = realloc(owner->saved_stack, size);
+            if (buffer == NULL) {
+                perror("Erreur lors de la sauvegarde de la pile partagée");
+                abort();
+            }
+            mem_stats.stacks += size;
+            mem_stats.stacks -= owner->saved_capacity;
+            owner->saved_stack = buffer;
+            owner->saved_capacity = size;
+        }
+        memcpy(owner->saved_stack, top - size, size);
+        owner->saved_size = size;
+    }
+    memcpy(top - next->saved_size, next->saved_stack, next->saved_size);
+    worker.shared_owner = next;
+    return &next->ctx;
+}
+
+/*******************************
+    Profilage des piles
+********************************/
+
+/**
+ * Peindre toute la pile d'un thread avec un motif connu avant son premier lancement.
+ * Toutes les pages de la pile deviennent résidentes : ce mode est réservé au profilage.
+ */
+static void stack_paint(struct thread *thread){
+    uint64_t *word = thread->stack;
+    uint64_t *end = thread->stack + thread->stack_size;
+    while (word < end) {
+        *word++ = STACK_PAINT;
+    }
+    thread->painted = 1;
+}
+
+/**
+ * Entrée de profilage d'une fonction, créée si nécessaire
+ */
+static struct stack_profile_entry *stack_profile_lookup(void *(*func)(void *), int create){
+    unsigned long bucket = ((uintptr_t)func >> 4) % STACK_PROFILE_BUCKETS;
+    struct stack_profile_entry *entry = stack_profiles[bucket];
+    while (entry != NULL && entry->func != func) {
+        entry = entry->next;
+    }
+    if (entry == NULL && create) {
+        entry = calloc(1, sizeof(struct stack_profile_entry));
+        if (entry != NULL) {
+            entry->func = func;
+            entry->next = stack_profiles[bucket];
+            stack_profiles[bucket] = entry;
+        }
+    }
+    return entry;
 }
 
-signal_t *get_signal (signal_type type) {
-    switch (type){
-    case SIG_USER1 :
-        return &signals[0];
-        break;
-    case SIG_USER2 :
-        return &signals[1];
-        break;
-    case SIG_KILL :
-        return &signals[3];
-        break;
-    default:
-        return &no_signal;
-        break;
+/**
+ * Mesurer la plus haute marque de la pile du thread courant (premier mot du bas
+ * de la pile qui n'a plus le motif) et l'ajouter aux statistiques de sa fonction
+ */
+static void stack_profile_record(struct thread *thread){
+    uint64_t *word = thread->stack;
+    uint64_t *end = thread->stack + thread->stack_size;
+    while (word < end && *word == STACK_PAINT) {
+        word++;
+    }
+    size_t used = (void *)end - (void *)word;
+    struct stack_profile_entry *entry = stack_profile_lookup(thread->func, 1);
+    if (entry != NULL) {
+        entry->samples++;
+        entry->total += used;
+        if (used > entry->max) {
+            entry->max = used;
+        }
+        entry->histogram[stack_class(used)]++;
     }
+    thread->painted = 0;
 }
 
-int  get_thread_current_signal(thread_t *thread) {
-    return (*thread)->th->current_signal;
+/**
+ * Taille de pile choisie pour une fonction : le double de la plus haute marque observée,
+ * plus une marge pour les trames de signaux. 0 (taille par défaut) tant que les mesures sont trop peu nombreuses.
+ */
+static size_t stack_autotune_size(void *(*func)(void *)){
+    struct stack_profile_entry *entry = stack_profile_lookup(func, 0);
+    if (entry == NULL || entry->samples < AUTOTUNE_MIN_SAMPLES) {
+        return 0;
+    }
+    return STACK_CLASS_SIZE(stack_class(2 * entry->max + AUTOTUNE_SLACK));
 }
 
-void set_thread_signal_array(thread_t *thread, int index, signal_t *signal){
-    (*thread)->th->signal_array[index] = signal;
-    (*thread)->th->current_signal = index+1;
+/**
+    @fn int thread_stack_profile_enable(int enable)
+    @brief Activer ou désactiver la mesure des plus hautes marques de pile
+    @param enable 1 pour activer, 0 pour désactiver
+    @return 0
+ */
+int thread_stack_profile_enable(int enable){
+    stack_profiling = enable != 0;
+    return 0;
 }
 
-void thread_signal_init(thread_signal_t *th){
-    if(th != NULL){
-        int i = 0;
-        for (i=0; i<MAX_SIGNALS; i++){
-            th->signal_array[i] = &no_signal;
-        }
-        th->current_signal = 0;
+/**
+    @fn int thread_stack_autotune_enable(int enable)
+    @brief Activer ou désactiver le choix automatique de la taille de pile
+    L'auto-ajustement active aussi la mesure des plus hautes marques.
+    @param enable 1 pour activer, 0 pour désactiver
+    @return 0
+ */
+int thread_stack_autotune_enable(int enable){
+    stack_autotune = enable != 0;
+    if (stack_autotune) {
+        stack_profiling = 1;
     }
+    return 0;
 }
 
-int thread_signal_free(thread_signal_t *th){
-  if(th != NULL){
-    free(th);
+/**
+    @fn int thread_stack_profile_get(void *(*func)(void *), thread_stack_profile_t *profile)
+    @brief Récupérer les statistiques de pile d'une fonction d'entrée de thread
+    @return 0 si réussi, -1 si aucun thread de cette fonction n'a été mesuré
+ */
+int thread_stack_profile_get(void *(*func)(void *), thread_stack_profile_t *profile){
+    struct stack_profile_entry *entry = stack_profile_lookup(func, 0);
+    if (entry == NULL || profile == NULL) {
+        return -1;
+    }
+    profile->samples = entry->samples;
+    profile->max = entry->max;
+    profile->mean = entry->total / entry->samples;
+    profile->suggested = stack_autotune_size(func);
     return 0;
-  }
-  return -1;
 }
 
-void default_signal_handler(signal_type sig) {
-    switch (sig){
-    case SIG_KILL:
-        printf("thread %d receives signal SIG_KILL \n", current_thread->id);
-        thread_exit(NULL);
-        break;
-    case SIG_USER1 :
-        printf("thread %d receives SIG_USER1 \n",current_thread->id);
-        break;
-    case SIG_USER2 :
-        printf("thread %d receives SIG_USER2 \n",current_thread->id);
-        break;
-    default:
-        break;
+/**
+    @fn void thread_stack_profile_report(FILE *out)
+    @brief Afficher l'histogramme des plus hautes marques de pile par fonction d'entrée
+ */
+void thread_stack_profile_report(FILE *out){
+    Dl_info info;
+    fprintf(out, "Plus hautes marques de pile par fonction d'entrée\n");
+    for (int i = 0; i < STACK_PROFILE_BUCKETS; i++) {
+        for (struct stack_profile_entry *entry = stack_profiles[i]; entry != NULL; entry = entry->next) {
+            const char *name = "?";
+            if (dladdr((void *)entry->func, &info) && info.dli_sname != NULL) {
+                name = info.dli_sname;
+            }
+            fprintf(out, "%p (%s): %lu threads, max %zu o, moyenne %zu o\n",
+                    (void *)entry->func, name, entry->samples, entry->max, entry->total / entry->samples);
+            for (int class = 0; class < NB_STACK_CLASSES; class++) {
+                if (entry->histogram[class]) {
+                    fprintf(out, "    <= %8zu o : %lu\n", STACK_CLASS_SIZE(class), entry->histogram[class]);
+                }
+            }
+        }
     }
-  
 }
 
-char * signal_enum_to_string(int signal){
-    switch(signal){
-        case SIG_USER1: return "SIG_USER1"; break;
-        case SIG_USER2: return "SIG_USER2"; break;
-        case SIG_KILL : return "SIG_KILL"; break;
-        default: return "unknown"; break;
+/**
+ * Hook exécuté sur la pile de l'ordonnanceur lors d'un changement de contexte :
+ * libère le thread détaché qui vient de se terminer, exécute les tâches sans pile en attente,
+ * puis prépare la pile partagée si le thread entrant en a besoin.
+ */
+static struct thread_context *sched_hook(void *arg){
+    struct thread *next = arg;
+    struct thread_context *ctx = &next->ctx;
+    if (worker.dead != NULL) {
+        thread_free(worker.dead);
+        worker.dead = NULL;
     }
+    tasks_run();
+    if (next->stack_class < 0 && worker.shared_owner != next) {
+        ctx = shared_stack_exchange(next);
+    }
+    return ctx;
 }
-/*******************************  
-    Side Function Implementation 
-********************************/
 
 /**
- * Fonction d'initialisation de notre librairie
+ * Bloquer le thread courant jusqu'à la terminaison de count des threads dont il est le joiner
  */
-void initializer(void){
-    queue_init();
-    main_thread = thread_init();
-    current_thread = main_thread;
-    add_thread_to_queue_tail(main_thread);
-    number_thread++;
-    #ifdef PREEMPTION
-    install_handler();
-    #ifdef PREEMPTION
-    init_timer(TIMESLICE);
-    #endif
-    #ifdef RR
-    init_timer(main_thread->time_slice);
+static void join_wait(struct thread *self, int count){
+    self->join_pending = count;
+    remove_thread_from_queue(self);
+    self->state = THREAD_BLOCKED;
+    update_thread_priority(self);
+    current_thread = get_thread();
+    handle_swap(self, current_thread);
+}
+
+/**
+ * Remettre le joiner d'un thread qui se termine à la place de celui-ci dans la file, sans
+ * repasser par get_thread(). Refusé si un thread prêt de plus haute priorité attend
+ * @return 1 si le joiner a pris la place du thread sortant, 0 sinon
+ */
+static int join_handoff(struct thread *self, struct thread *joiner){
+    #ifdef FIFO
+    TAILQ_INSERT_BEFORE(self, joiner, threads);
+    TAILQ_REMOVE(&ready, self, threads);
     #endif
-    setitimer(ITIMER_VIRTUAL, &timer, NULL);
+
+    #ifdef PRIORITY
+    for (int i = MAX_PRIORITY - 1; i > joiner->priority; i--) {
+        struct thread *first = TAILQ_FIRST(&ready[i].threads);
+        if (first != NULL && (first != self || TAILQ_NEXT(self, threads) != NULL)) {
+            return 0;
+        }
+    }
+    TAILQ_REMOVE(&ready[self->priority].threads, self, threads);
+    TAILQ_INSERT_HEAD(&ready[joiner->priority].threads, joiner, threads);
     #endif
+    joiner->state = THREAD_READY;
+    return 1;
 }
 
 /**
- * Fonction de libération de notre librairie
+ * Vérifier qu'un ensemble de threads peut être attendu par le thread courant
  */
-void cleaner(void){
-    if(main_thread!=NULL){
-        VALGRIND_STACK_DEREGISTER(main_thread->valgrind_stackid);
-        #ifdef STACKOVERFLOW
-        free(main_thread->uc.uc_stack.ss_sp-PAGE_SIZE);
-        #else
-        free(main_thread->uc.uc_stack.ss_sp);
-        #endif
-        thread_signal_free(main_thread->th); 
-        free(main_thread);
+static int join_check(thread_t *threads, int n){
+    int i;
+    if (threads == NULL || n < 0) {
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        if (threads[i] == NULL || threads[i]->detached || threads[i]->joiner != NULL) {
+            return -1;
+        }
+        if (threads[i] == current_thread) {
+            return EDEADLK;
+        }
     }
+    return 0;
 }
 
+/**
+ * Place restante sous le pointeur de pile courant, sur la pile du thread courant
+ */
+static size_t stack_headroom(void){
+    char *sp = __builtin_frame_address(0);
+    char *low = current_thread == main_thread ? main_stack_low : (char *) current_thread->stack;
+    return sp > low ? (size_t) (sp - low) : 0;
+}
 
-#ifdef STACKOVERFLOW
 /**
- * Fonction de gestion de segfault
+ * Repérer la limite basse de la pile du programme principal, d'après RLIMIT_STACK
  */
-void segfault_handler(int sig, siginfo_t *si, void *unused) {
-    (void) unused;
-    (void) si;
-    (void) sig;
-    printf("segfault_handler\n");
-    
-    if(current_thread == main_thread){
-        printf("Main segfaulted\n");
-        _exit(1);
-    }
-    else {
-        printf("Signal SIGSEGV (segfault) reçu in %p.\n", current_thread);
-        printf("Adresse mémoire problématique : %p\n", si->si_addr);
-        thread_exit(NULL);
+static void main_stack_init(void){
+    struct rlimit limit;
+    size_t size = 8 * 1024 * 1024;
+    char *sp = __builtin_frame_address(0);
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        size = limit.rlim_cur;
     }
-
+    /* marge pour l'environnement et les arguments situés au-dessus de main */
+    main_stack_low = sp - size + SPAWN_HEADROOM;
 }
 
-void* sp[SIGSTKSZ];
-#endif 
 /**
  * Créer et initialiser un thread 
  */
-struct thread * thread_init(void){
-    //printf("init\n");
-    struct thread * thread = malloc(sizeof(struct thread));
-    thread->th = malloc(sizeof(thread_signal_t));
-    thread_signal_init(thread->th);
-    thread->retval = NULL;
-    getcontext(&thread->uc);
-    #ifdef STACKOVERFLOW
-    void * stack;
-    //printf("titi1\n");
-    if(posix_memalign(&stack, PAGE_SIZE, CONTEXT_STACK_SIZE+PAGE_SIZE) != 0){
-        printf("Erreur lors de l'initialisation de la stack du thread\n");
-        fflush(stdout);
+struct thread * thread_init(const thread_attr_t *attr){
+    struct thread * thread = descriptor_alloc();
+    if (thread == NULL) {
         return NULL;
     }
-    if (mprotect(stack, PAGE_SIZE, 0) != 0) {
-        printf("Erreur lors de la protection en écriture et en lecture de la fin de la pile\n");
-        return NULL;
+    thread->saved_stack = NULL;
+    thread->saved_size = 0;
+    thread->saved_capacity = 0;
+    thread->func = NULL;
+    thread->painted = 0;
+    if (attr != NULL && attr->shared_stack) {
+        if (shared_stack_init() != 0) {
+            descriptor_free(thread);
+            return NULL;
+        }
+        thread->stack_class = -1;
+        thread->stack = worker.shared_stack;
+        thread->stack_size = SHARED_STACK_SIZE;
     }
-    thread->uc.uc_stack.ss_sp =stack+PAGE_SIZE;
-
+    else {
+        thread->stack_class = stack_class(attr ? attr->stack_size : 0);
+        thread->stack = stack_alloc(thread->stack_class);
+        if (thread->stack == NULL) {
+            descriptor_free(thread);
+            return NULL;
+        }
+        thread->stack_size = STACK_CLASS_SIZE(thread->stack_class);
+        thread->valgrind_stackid=VALGRIND_STACK_REGISTER(
+                                thread->stack,
+                                thread->stack + 
+                                thread->stack_size
+                                );
+    }
+    thread_signal_init(thread->th);
+    thread->retval = NULL;
+    thread->detached = attr != NULL && attr->detached == THREAD_CREATE_DETACHED;
+    thread->timeslice = attr != NULL ? attr->timeslice : 0;
+    thread->preempt_count = 0;
+    thread->sched_score = 0;
+    #ifdef STACKOVERFLOW
     if(current_thread == NULL){
         // Débordement de pile
         stack_t ss;
         ss.ss_sp = sp;
-        ss.ss_size = SIGSTKSZ;
+        ss.ss_size = SIGNAL_STACK_SIZE;
         ss.ss_flags = 0;
 
         // Définir la pile alternative avec sigaltstack
@@ -865,7 +3263,7 @@ struct thread * thread_init(void){
         }
         // Installer un gestionnaire de signal pour SIGSEGV
         struct sigaction sa;
-        sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sa.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
         sa.sa_sigaction = segfault_handler;
         sigemptyset(&sa.sa_mask);
         if (sigaction(SIGSEGV, &sa, NULL) == -1) {
@@ -873,23 +3271,30 @@ struct thread * thread_init(void){
             return NULL;
         }
     }
-    #else
-    thread->uc.uc_stack.ss_sp = malloc(CONTEXT_STACK_SIZE);
     #endif
-    thread->uc.uc_stack.ss_size = CONTEXT_STACK_SIZE;
-    thread->valgrind_stackid=VALGRIND_STACK_REGISTER(
-                            thread->uc.uc_stack.ss_sp,
-                            thread->uc.uc_stack.ss_sp + 
-                            thread->uc.uc_stack.ss_size
-                            );
-    thread->uc.uc_link = NULL;
     thread->id =number_thread;
-    thread->is_done=0;
+    thread->state = THREAD_READY;
     thread->joiner = NULL;
-    thread->is_locked=0;
+    thread->join_pending = 0;
+    thread->join_first = NULL;
+    thread->scope_next = NULL;
+    thread->wait_next = NULL;
+    thread->wait_mutex = NULL;
+    thread->mutex_held = 0;
+    thread->base_priority = -1;
+    thread->boost_priority = -1;
+    thread->wait_writer = 0;
+    thread->wait_addr = NULL;
+    thread->specific = thread->specific_inline;
+    thread->specific_size = THREAD_KEY_INLINE;
+    memset(thread->specific_inline, 0, sizeof(thread->specific_inline));
     thread->id_first = -1; //Id positif seulement. On peut pas mettre 0 sinon on détecte une boucle avec lui même -> Deadlock
-    thread-> priority = MAX_PRIORITY-1%(number_thread+1);
+    thread->priority = (MAX_PRIORITY-1) - number_thread % MAX_PRIORITY;
+    if (attr != NULL && attr->priority >= 0) {
+        set_thread_priority(thread, attr->priority);
+    }
 
+    mem_stats.nb_threads++;
     return thread;
 }
 
@@ -898,15 +3303,48 @@ struct thread * thread_init(void){
  */
 void handle_swap(struct thread *thread,struct thread *next){
     #ifdef PREEMPTION
-    setitimer(ITIMER_VIRTUAL, &timer, &remainingtime);
-    enable_interrupt();
+    preempt_timer_update(next);
     #endif
-    swapcontext(&thread->uc,&next->uc);
+    /**
+     * Plus aucun thread prêt : l'appelant décide de la suite (thread_exit termine le processus)
+     */
+    if (next == NULL) {
+        return;
+    }
+    if (next != thread) {
+        sched_stats.switches++;
+    }
+    sched_account(thread);
+    /**
+     * Le changement de contexte honore un éventuel tick différé ; chaque thread retrouve
+     * à sa reprise la profondeur de sections critiques qu'il avait en partant
+     */
+    worker.preempt_pending = 0;
+    thread_resched = 0;
+    thread->preempt_count = worker.preempt_count;
+    /**
+     * Un thread détaché terminé ne peut être libéré qu'une fois sa pile quittée, et un thread
+     * en mode pile partagée ne peut reprendre qu'une fois ses trames recopiées :
+     * les deux se font depuis la pile de l'ordonnanceur
+     */
+    if (thread->detached && thread->state == THREAD_DONE && thread != main_thread) {
+        worker.dead = thread;
+    }
+    if (worker.dead != NULL || !STAILQ_EMPTY(&worker.tasks)
+        || (next->stack_class < 0 && worker.shared_owner != next)) {
+        context_switch_call(&thread->ctx, sched_hook, next,
+                            worker.sched_stack + SCHED_STACK_SIZE);
+    }
+    else {
+        context_switch(&thread->ctx,&next->ctx);
+    }
+    worker.preempt_count = thread->preempt_count;
 }
 /**
  * fonction intermédiaire pour nos thread
  */
 void call_function(void *(*func)(void*), void *funcarg){
+    worker.preempt_count = 0;
     void * retval = func(funcarg);
     thread_exit(retval);
 }
@@ -917,44 +3355,196 @@ void call_function(void *(*func)(void*), void *funcarg){
  */
 void timer_handler(){
     #ifdef PREEMPTION
-    disable_interrupt();
-    if(is_queue_empty()){
-        setitimer(ITIMER_VIRTUAL, &timer, NULL);
+    /**
+     * Tick reçu en section critique (file des threads, changement de contexte, pile de
+     * l'ordonnanceur) : le changement de thread est différé jusqu'à enable_interrupt()
+     */
+    if (worker.preempt_count > 0) {
+        worker.preempt_pending = 1;
+        return;
     }
-    thread_yield();
+    preempt();
     #endif
 }
+
+#ifdef PREEMPTION
+/**
+ * Céder le processeur sur préemption. Si le thread courant est seul prêt,
+ * le timer est désarmé sans changer de thread
+ */
+static void preempt(void){
+    if (nb_ready <= 1) {
+        preempt_timer_update(current_thread);
+        return;
+    }
+    sched_stats.preemptions++;
+    worker.preempting = 1;
+    thread_yield();
+}
+#endif
 /**
- * Initialiser le timer pour le mécanisme préemption
+ * Initialiser le timer pour le mécanisme préemption (time_slice en ms).
+ * Chaque worker a son propre timer POSIX, sur l'horloge CPU de son thread noyau :
+ * il n'est pas armé tant qu'un seul thread est prêt
  */
 void init_timer(int time_slice){
-    getitimer(ITIMER_VIRTUAL,&timer);
-    timer.it_value.tv_sec = time_slice/1000;
-    timer.it_value.tv_usec = (time_slice * 1000) % 1000000;
-    timer.it_interval.tv_sec = 0;
-    timer.it_interval.tv_usec = 0;
+    timeslice = (unsigned long) time_slice * 1000;
+    if (preempt_timer_create(THREAD_PREEMPT_SIGNAL, &worker.timer) != 0) {
+        perror("Erreur lors de la création du timer de préemption");
+    }
+}
+
+/**
+ * Fin de tranche en mode coopératif, exécutée par le thread de notification du timer
+ */
+static void resched_notify(union sigval sv){
+    (void) sv;
+    thread_resched = 1;
+}
+
+/**
+ * Créer le timer du worker : en mode signal, il envoie SIGVTALRM au thread noyau du
+ * worker (SIGEV_THREAD_ID) ; en mode coopératif, il lève seulement thread_resched
+ */
+static int preempt_timer_create(int mode, timer_t *timer){
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    if (mode == THREAD_PREEMPT_COOPERATIVE) {
+        sev.sigev_notify = SIGEV_THREAD;
+        sev.sigev_notify_function = resched_notify;
+    }
+    else {
+        sev.sigev_notify = SIGEV_THREAD_ID;
+        sev.sigev_signo = SIGVTALRM;
+        sev.sigev_notify_thread_id = gettid();
+    }
+    return timer_create(PREEMPT_CLOCK, &sev, timer);
+}
+
+/**
+ * Armer le timer de préemption dès qu'un autre thread que le thread courant est prêt,
+ * et le désarmer lorsque la file se vide. Le timer est périodique : il n'est reprogrammé
+ * que lors de ces transitions, ou si le thread entrant a sa propre tranche de temps
+ */
+static void preempt_timer_update(struct thread *next){
+    #ifdef PREEMPTION
+    struct itimerspec its;
+    unsigned long slice = 0;
+    if (nb_ready > 1) {
+        slice = thread_slice(next);
+    }
+    if (slice == worker.timer_slice) {
+        return;
+    }
+    worker.timer_slice = slice;
+    its.it_value.tv_sec = slice / 1000000;
+    its.it_value.tv_nsec = (slice % 1000000) * 1000;
+    its.it_interval = its.it_value;
+    timer_settime(worker.timer, 0, &its, NULL);
+    sched_stats.timer_updates++;
+    #else
+    (void) next;
+    #endif
+}
+/**
+ * Tranche effective d'un thread : la sienne s'il en a une, sinon la tranche par défaut,
+ * raccourcie pour un thread interactif et allongée pour un thread calculatoire
+ */
+static unsigned long thread_slice(struct thread *thread){
+    if (thread == NULL) {
+        return timeslice;
+    }
+    if (thread->timeslice) {
+        return thread->timeslice;
+    }
+    if (sched_adaptive) {
+        switch (thread_get_sched_class(thread)) {
+        case THREAD_SCHED_INTERACTIVE:
+            return timeslice / 2 < THREAD_TIMESLICE_MIN ? THREAD_TIMESLICE_MIN : timeslice / 2;
+        case THREAD_SCHED_CPU:
+            return timeslice * 2;
+        }
+    }
+    return timeslice;
+}
+/**
+ * Noter comment le thread sortant quitte le processeur : préempté par le timer,
+ * ou de lui-même (passage de main, attente, terminaison)
+ */
+static void sched_account(struct thread *thread){
+    if (worker.preempting) {
+        worker.preempting = 0;
+        if (thread->sched_score > -SCHED_SCORE_MAX) {
+            thread->sched_score--;
+        }
+    }
+    else if (thread->sched_score < SCHED_SCORE_MAX) {
+        thread->sched_score++;
+    }
+}
+/**
+ * Rendre prêt un thread réveillé. Un thread interactif passe devant les threads
+ * prêts, juste derrière le thread courant, pour s'exécuter dès le prochain changement.
+ * En PRIORITY, il monte au niveau le plus haut jusqu'à ce qu'il cède la main
+ */
+static void thread_unpark(struct thread *thread){
+    if (!sched_adaptive || thread_get_sched_class(thread) != THREAD_SCHED_INTERACTIVE) {
+        add_thread_to_queue_tail(thread);
+        return;
+    }
+    sched_stats.boosts++;
+    #ifdef FIFO
+    if (current_thread != NULL && current_thread->state == THREAD_READY) {
+        thread->state = THREAD_READY;
+        TAILQ_INSERT_AFTER(&ready, current_thread, thread, threads);
+        nb_ready++;
+        preempt_timer_update(current_thread);
+        return;
+    }
+    #endif
+
+    #ifdef PRIORITY
+    if (thread->base_priority < 0 && thread->boost_priority < 0) {
+        thread->boost_priority = thread->priority;
+        thread->priority = MAX_PRIORITY-1;
+    }
+    #endif
+    add_thread_to_queue_head(thread);
 }
 /**
  * Installer le signal handler pour le signal de préemption
  */
 void install_handler(void){
     act_timer.sa_handler = &timer_handler;
-    act_timer.sa_flags=0;
+    /**
+     * Le handler change de thread sans en revenir : le changement de contexte ne restaurant
+     * pas le masque de signaux, SIGVTALRM ne doit pas rester bloqué pendant son exécution
+     */
+    act_timer.sa_flags=SA_NODEFER;
     sigemptyset(&act_timer.sa_mask);
-    sigaddset(&act_timer.sa_mask, SIGVTALRM);
     sigaction(SIGVTALRM, &act_timer, NULL);
 }
 /**
- * Permettre au thread de capturer le signal de préemption 
+ * Sortir d'une section critique. En sortant de la dernière, le tick reçu entre-temps
+ * est honoré : le thread courant cède alors le processeur
  */
 void enable_interrupt(void){
-    sigemptyset(&act_timer.sa_mask);
+    #ifdef PREEMPTION
+    if (--worker.preempt_count == 0 && worker.preempt_pending) {
+        worker.preempt_pending = 0;
+        preempt();
+    }
+    #endif
 }
 /**
- * Bloquer la capture du signal de préemption par le thread
+ * Entrer dans une section critique : le handler de préemption ne change plus de thread
+ * mais note le tick. Les sections s'imbriquent ; le signal n'est jamais bloqué, ce qui
+ * ne coûte qu'une écriture en mémoire au lieu d'un appel à sigprocmask()
  */
 void disable_interrupt(void){
-     sigaddset(&act_timer.sa_mask, SIGVTALRM);
+    #ifdef PREEMPTION
+    worker.preempt_count++;
+    #endif
 }
 
 
@@ -983,6 +3573,7 @@ void queue_init(void) {
  * Fonction pour ajouter un thread à la queue de la file d'attente
  */
 void add_thread_to_queue_tail(struct thread *thread){
+    thread->state = THREAD_READY;
     /**
      *  code pour l'ordonnancement avec FIFO 
      */
@@ -996,11 +3587,34 @@ void add_thread_to_queue_tail(struct thread *thread){
     #ifdef PRIORITY
     TAILQ_INSERT_TAIL(&ready[thread->priority].threads, thread, threads);
     #endif
+    nb_ready++;
+    preempt_timer_update(current_thread);
+}
+/**
+ * Ajouter une liste de count threads prêts à la queue de la file d'attente.
+ * En FIFO, la liste est raccordée en une seule opération ; la liste est vide au retour
+ */
+static void add_threads_to_queue_tail(struct threadlist *list, int count){
+    #ifdef FIFO
+    TAILQ_CONCAT(&ready, list, threads);
+    nb_ready += count;
+    preempt_timer_update(current_thread);
+    #endif
+
+    #ifdef PRIORITY
+    struct thread *thread;
+    (void) count;
+    while ((thread = TAILQ_FIRST(list)) != NULL) {
+        TAILQ_REMOVE(list, thread, threads);
+        add_thread_to_queue_tail(thread);
+    }
+    #endif
 }
 /**
  * Fonction pour ajouter un thread à la tête de la file d'attente correspondant à sa priorité
  */
 void add_thread_to_queue_head(struct thread *thread){
+    thread->state = THREAD_READY;
     /**
      *  code pour l'ordonnancement avec FIFO 
      */
@@ -1014,6 +3628,8 @@ void add_thread_to_queue_head(struct thread *thread){
     #ifdef PRIORITY
     TAILQ_INSERT_HEAD(&ready[thread->priority].threads, thread, threads);
     #endif
+    nb_ready++;
+    preempt_timer_update(current_thread);
 }
 /**
  * Fonction pour supprimer un thread de la queue de la file d'attente correspondant à sa priorité
@@ -1032,6 +3648,7 @@ void remove_thread_from_queue(struct thread *thread) {
     #ifdef PRIORITY
     TAILQ_REMOVE(&ready[thread->priority].threads, thread, threads);
     #endif
+    nb_ready--;
 }
 /**
  *  Fonction pour récupérer le premier thread dans la file d'attente avec la priorité la plus haute
@@ -1053,6 +3670,7 @@ struct thread* get_thread(void) {
             return TAILQ_FIRST(&ready[i].threads);
         }
     }
+    return NULL;
     #endif
 }
 /**
@@ -1070,6 +3688,19 @@ void update_thread_priority(struct thread *thread) {
      *  code pour l'ordonnancement avec priorité 
      */
     #ifdef PRIORITY
+    /**
+     * Une priorité héritée est conservée jusqu'au dernier thread_mutex_unlock()
+     */
+    if (thread->base_priority >= 0) {
+        return;
+    }
+    /**
+     * Le coup de pouce d'un réveil ne dure que jusqu'au passage de main suivant
+     */
+    if (thread->boost_priority >= 0) {
+        thread->priority = thread->boost_priority;
+        thread->boost_priority = -1;
+    }
     thread->priority = thread->priority-1;
     if (thread->priority < 0) {
         thread->priority = MAX_PRIORITY-1;
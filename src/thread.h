@@ -3,6 +3,9 @@
 
 #ifndef USE_PTHREAD
 
+#include <stddef.h>
+#include <stdio.h>
+
 
 /* identifiant de thread
  * NB: pourra être un entier au lieu d'un pointeur si ca vous arrange,
@@ -41,13 +44,345 @@ extern int thread_join(thread_t thread, void **retval);
  */
 extern void thread_exit(void *retval);
 
-/* Interface possible pour les mutex */
-typedef struct thread_mutex { thread_t locked; } thread_mutex_t;
+/* détacher un thread : sa pile et son descripteur seront libérés dès sa
+ * terminaison, et il ne pourra plus être joint.
+ * renvoie 0 en cas de succès, -1 si le thread est déjà détaché ou attendu.
+ */
+extern int thread_detach(thread_t thread);
+
+/* attendre la fin de n threads distincts en ne se bloquant qu'une fois :
+ * le thread appelant n'est réveillé que par la terminaison du dernier d'entre eux.
+ * si retvals n'est pas NULL, retvals[i] reçoit la valeur renvoyée par threads[i].
+ * renvoie 0 en cas de succès, -1 si un des threads est NULL, détaché ou déjà
+ * attendu, EDEADLK si le thread appelant fait partie des threads attendus.
+ */
+extern int thread_join_many(thread_t *threads, int n, void **retvals);
+
+/* attendre la fin du premier des n threads à se terminer et le joindre
+ * (sa valeur de retour est placée dans *retval si retval n'est pas NULL).
+ * les autres threads restent à joindre.
+ * renvoie l'indice du thread joint, -1 ou EDEADLK en cas d'erreur.
+ */
+extern int thread_join_any(thread_t *threads, int n, void **retval);
+
+/* Données propres à chaque thread : une clé désigne une case dans chaque
+ * thread, qui vaut NULL tant que le thread n'y a rien rangé. Les premières
+ * cases sont dans le descripteur du thread, les suivantes sont allouées à la
+ * première écriture : thread_getspecific() n'est qu'une lecture indexée.
+ * Quand un thread se termine, par retour ou par thread_exit(), le destructeur
+ * d'une clé est appelé sur chacune de ses valeurs non NULL, en au plus
+ * THREAD_DESTRUCTOR_ITERATIONS tours. Les indices des clés supprimées ne
+ * sont pas réutilisés : au plus THREAD_KEYS_MAX clés sont créées en tout.
+ */
+#define THREAD_KEYS_MAX 1024
+#define THREAD_DESTRUCTOR_ITERATIONS 4
+
+typedef unsigned int thread_key_t;
+
+int thread_key_create(thread_key_t *key, void (*destructor)(void *));
+int thread_key_delete(thread_key_t key);
+void *thread_getspecific(thread_key_t key);
+int thread_setspecific(thread_key_t key, const void *value);
+
+/* Portée de threads : tous les threads créés par thread_scope_spawn() sont
+ * joints par thread_scope_join(), qui ne bloque qu'une fois pour l'ensemble.
+ * Ces threads ne doivent être ni joints ni détachés individuellement.
+ */
+typedef struct thread_scope {
+    thread_t threads;   /* threads créés dans la portée, chaînés entre eux */
+    int count;          /* nombre de threads de la portée */
+} thread_scope_t;
+
+int thread_scope_init(thread_scope_t *scope);
+int thread_scope_spawn(thread_scope_t *scope, thread_t *newthread,
+                       void *(*func)(void *), void *funcarg);
+int thread_scope_join(thread_scope_t *scope);
+
+/* Parallélisme récursif à la Cilk : thread_spawn() exécute d'abord func(arg)
+ * directement sur la pile de l'appelant, comme un simple appel de fonction.
+ * Lorsque la place restante sur la pile devient insuffisante, l'enfant est
+ * promu en véritable thread, que thread_sync() attend.
+ * un enfant exécuté en ligne voit le thread appelant comme thread_self() et
+ * doit se terminer par un retour, jamais par thread_exit().
+ */
+typedef struct thread_task {
+    void *retval;       /* valeur renvoyée par l'enfant, valide après thread_sync() */
+    thread_t thread;    /* thread de l'enfant s'il a été promu, NULL sinon */
+} thread_task_t;
+
+/* lancer func(arg), en ligne si possible.
+ * renvoie 0 en cas de succès, -1 en cas d'erreur.
+ */
+int thread_spawn(thread_task_t *task, void *(*func)(void *), void *arg);
+
+/* attendre les n enfants lancés avec thread_spawn() en ne se bloquant
+ * qu'une fois pour ceux qui ont été promus.
+ * renvoie 0 en cas de succès, -1 en cas d'erreur.
+ */
+int thread_sync(thread_task_t *tasks, int n);
+
+/* Tâches sans pile : func(arg) s'exécute jusqu'au bout sur la pile de
+ * l'ordonnanceur, sans pile ni contexte propres. Les tâches soumises sont
+ * exécutées par lots au prochain changement de contexte, ou lorsqu'un thread
+ * attend l'une d'elles. Une tâche ne doit jamais bloquer ni appeler les
+ * fonctions d'ordonnancement (thread_yield, thread_join, mutex, ...).
+ */
+struct thread_job;
+typedef struct thread_job *thread_job_t;
+
+/* soumettre une tâche.
+ * renvoie son identifiant, NULL en cas d'erreur.
+ */
+thread_job_t thread_task_submit(void *(*func)(void *), void *arg);
+
+/* attendre la fin d'une tâche et libérer son identifiant.
+ * la valeur renvoyée par la tâche est placée dans *retval si retval n'est pas NULL.
+ * renvoie 0 en cas de succès, -1 si job est NULL.
+ */
+int thread_task_join(thread_job_t job, void **retval);
+
+/* Attributs de création d'un thread.
+ * Les piles sont allouées par classes de taille (puissances de deux de
+ * THREAD_STACK_MIN à THREAD_STACK_MAX) : la taille demandée est arrondie
+ * à la classe supérieure et les piles libérées sont réutilisées par classe.
+ * La pile par défaut réserve 1 Mio de mémoire virtuelle, dont seules les
+ * pages touchées sont réellement allouées.
+ */
+#define THREAD_STACK_MIN (4*1024)
+#define THREAD_STACK_MAX (8*1024*1024)
+
+typedef struct thread_attr {
+    size_t stack_size;  /* taille de pile en octets, 0 pour la taille par défaut */
+    int priority;       /* priorité initiale, -1 pour la valeur par défaut */
+    int shared_stack;   /* 1 pour s'exécuter sur la pile partagée du worker */
+    int detached;       /* THREAD_CREATE_JOINABLE ou THREAD_CREATE_DETACHED */
+    unsigned long timeslice; /* tranche de temps en µs, 0 pour la valeur par défaut */
+} thread_attr_t;
+
+#define THREAD_CREATE_JOINABLE 0
+#define THREAD_CREATE_DETACHED 1
+
+int thread_attr_init(thread_attr_t *attr);
+int thread_attr_destroy(thread_attr_t *attr);
+int thread_attr_setstacksize(thread_attr_t *attr, size_t stacksize);
+int thread_attr_getstacksize(const thread_attr_t *attr, size_t *stacksize);
+int thread_attr_setpriority(thread_attr_t *attr, int priority);
+
+/* priorité effective d'un thread (héritage compris), -1 si thread est NULL */
+int thread_get_priority(thread_t thread);
+
+/* Mode pile partagée : le thread s'exécute sur une pile commune, et seule la
+ * partie vivante de sa pile est copiée dans le tas lorsqu'un autre thread en
+ * mode pile partagée prend sa place. L'adresse d'une variable locale d'un tel
+ * thread ne doit donc jamais être transmise à un autre thread.
+ */
+int thread_attr_setsharedstack(thread_attr_t *attr, int shared);
+int thread_attr_setdetachstate(thread_attr_t *attr, int detachstate);
+int thread_attr_settimeslice(thread_attr_t *attr, unsigned long usec);
+
+/* Préemption : chaque worker arme un timer POSIX sur le temps CPU de son
+ * thread noyau, uniquement lorsque plusieurs threads sont prêts.
+ * La tranche de temps par défaut est de 10 ms, modifiable par la variable
+ * d'environnement THREAD_TIMESLICE (en µs) ou par thread_set_timeslice(NULL, ...).
+ * Un thread peut avoir sa propre tranche (thread_set_timeslice(thread, ...)
+ * ou thread_attr_settimeslice()), par exemple plus courte pour un thread
+ * sensible à la latence.
+ */
+#define THREAD_TIMESLICE_MIN 100
+
+int thread_set_timeslice(thread_t thread, unsigned long usec);
+unsigned long thread_get_timeslice(thread_t thread);
+
+/* Tranches adaptatives : l'ordonnanceur classe les threads d'après leurs
+ * derniers passages de main. Un thread qui bloque ou cède la main avant la fin
+ * de sa tranche devient interactif : tranche de moitié plus courte, et il est
+ * placé en tête de la file à son réveil (au niveau le plus haut en PRIORITY,
+ * jusqu'à son prochain passage de main). Un thread régulièrement préempté
+ * devient calculatoire : tranche deux fois plus longue. Une tranche propre au
+ * thread n'est jamais ajustée. Actif par défaut, désactivé par THREAD_ADAPTIVE=0.
+ */
+#define THREAD_SCHED_CPU -1
+#define THREAD_SCHED_NORMAL 0
+#define THREAD_SCHED_INTERACTIVE 1
+
+int thread_sched_adaptive_enable(int enable);
+int thread_get_sched_class(thread_t thread);
+
+/* Préemption coopérative : au lieu d'envoyer SIGVTALRM au worker, le timer
+ * lève un drapeau depuis un thread de notification, et c'est au thread courant
+ * de le consulter à des points sûrs (par exemple à chaque tour d'une longue
+ * boucle) avec thread_maybe_yield(), qui ne coûte qu'une lecture mémoire tant
+ * que la tranche n'est pas écoulée. Aucun signal n'interrompt alors un appel
+ * non réentrant de la libc. Choisi par thread_set_preempt_mode() ou par la
+ * variable d'environnement THREAD_PREEMPT=cooperative.
+ */
+#define THREAD_PREEMPT_SIGNAL 0
+#define THREAD_PREEMPT_COOPERATIVE 1
+
+int thread_set_preempt_mode(int mode);
+
+/* drapeau du worker, levé lorsque la tranche du thread courant est écoulée */
+extern volatile int thread_resched;
+
+/* céder le processeur comme sur préemption (différé en section critique) */
+void thread_preempt_point(void);
+
+static inline int thread_should_yield(void)
+{
+    return thread_resched;
+}
+
+static inline void thread_maybe_yield(void)
+{
+    if (thread_resched) {
+        thread_preempt_point();
+    }
+}
+
+typedef struct thread_sched_stats {
+    unsigned long switches;      /* changements de contexte */
+    unsigned long preemptions;   /* changements provoqués par le timer */
+    unsigned long timer_updates; /* reprogrammations du timer (appels système) */
+    unsigned long timeslice;     /* période programmée en µs, 0 si le timer est désarmé */
+    unsigned long boosts;        /* réveils de threads interactifs placés en tête de file */
+} thread_sched_stats_t;
+
+/* remplir *stats avec les compteurs de l'ordonnanceur.
+ * renvoie 0 en cas de succès, -1 si stats est NULL.
+ */
+int thread_get_sched_stats(thread_sched_stats_t *stats);
+
+/* Lorsqu'une pile est recyclée, seuls ses `bytes` octets du haut restent
+ * en mémoire, le reste est rendu au système (32 Kio par défaut, modifiable
+ * aussi par la variable d'environnement THREAD_STACK_WATERMARK).
+ */
+int thread_set_stack_watermark(size_t bytes);
+size_t thread_get_stack_watermark(void);
+
+/* Profilage des piles : les piles des nouveaux threads sont peintes avec un
+ * motif, et la plus haute marque atteinte est mesurée dans thread_exit()
+ * puis agrégée par fonction d'entrée. Le rapport est affiché sur la sortie
+ * d'erreur à la fin du programme.
+ * L'auto-ajustement choisit ensuite la taille de pile des threads créés sans
+ * taille explicite d'après les mesures déjà faites pour la même fonction.
+ * Activables aussi par les variables d'environnement THREAD_STACK_PROFILE=1
+ * et THREAD_STACK_AUTOTUNE=1.
+ */
+typedef struct thread_stack_profile {
+    unsigned long samples;  /* nombre de threads mesurés */
+    size_t max;             /* plus haute marque observée, en octets */
+    size_t mean;            /* moyenne des plus hautes marques */
+    size_t suggested;       /* taille choisie par l'auto-ajustement, 0 si inconnue */
+} thread_stack_profile_t;
+
+int thread_stack_profile_enable(int enable);
+int thread_stack_autotune_enable(int enable);
+int thread_stack_profile_get(void *(*func)(void *), thread_stack_profile_t *profile);
+void thread_stack_profile_report(FILE *out);
+
+/* creer un nouveau thread comme thread_create(), avec les attributs attr
+ * (NULL pour les valeurs par défaut).
+ * renvoie 0 en cas de succès, -1 en cas d'erreur.
+ */
+extern int thread_create_attr(thread_t *newthread, const thread_attr_t *attr,
+                              void *(*func)(void *), void *funcarg);
+
+/* creer n threads exécutant func en un seul appel : les piles sont réservées
+ * en bloc et les threads sont ajoutés d'un coup à la file des threads prêts.
+ * le thread i reçoit l'argument (char *) args + i * stride et son identifiant
+ * est placé dans out[i].
+ * renvoie 0 en cas de succès, -1 en cas d'erreur (aucun thread n'est créé).
+ */
+extern int thread_create_batch(thread_t *out, int n, void *(*func)(void *),
+                               void *args, size_t stride);
+
+/* Interface possible pour les mutex
+ * Sans contention, prendre et relâcher le mutex coûte une seule opération
+ * atomique (CAS) sur le mot de verrou. Sinon, le thread attend activement un
+ * nombre borné d'itérations, ajusté à chaque acquisition, tant que le
+ * détenteur s'exécute sur un autre worker, puis se bloque dans la file
+ * d'attente ; le mutex est transmis directement au thread réveillé par
+ * thread_mutex_unlock().
+ * Avec l'ordonnancement par priorité, le plus prioritaire des threads en attente
+ * est réveillé le premier, et le détenteur hérite de sa priorité jusqu'à ce
+ * qu'il ait relâché tous ses mutex (héritage de priorité).
+ */
+typedef struct thread_lock_profile {
+    void *site;                 /* adresse de retour de l'appel à thread_mutex_init() */
+    unsigned long mutexes;      /* mutex initialisés à cet endroit */
+    unsigned long acquisitions;
+    unsigned long contended;    /* acquisitions où le mutex était déjà pris */
+    unsigned long wait_total;   /* temps d'attente cumulé, en ns */
+    unsigned long wait_max;     /* plus longue attente, en ns */
+    unsigned long hold_total;   /* temps de détention cumulé, en ns */
+} thread_lock_profile_t;
+
+typedef struct thread_mutex {
+    unsigned long word; /* adresse du détenteur, bit 0 levé si des threads attendent, 0 si libre */
+    thread_t waiters;   /* threads en attente, dans l'ordre d'arrivée */
+    int spin;           /* itérations d'attente active estimées pour ce mutex */
+    thread_lock_profile_t *profile; /* statistiques de son site d'initialisation, NULL sans profilage */
+    unsigned long since;            /* date de la dernière acquisition en ns, avec profilage */
+} thread_mutex_t;
 int thread_mutex_init(thread_mutex_t *mutex);
 int thread_mutex_destroy(thread_mutex_t *mutex);
 int thread_mutex_lock(thread_mutex_t *mutex);
 int thread_mutex_unlock(thread_mutex_t *mutex);
 
+/* Profilage de la contention des mutex : les mutex initialisés pendant que le
+ * profilage est actif sont regroupés par site d'appel de thread_mutex_init(),
+ * et chaque acquisition y est comptée avec son temps d'attente et de détention.
+ * Le rapport, trié par temps d'attente cumulé décroissant, est affiché sur la
+ * sortie d'erreur à la fin du programme. Sans profilage, le surcoût se limite
+ * à un test par acquisition. Activable aussi par THREAD_LOCK_PROFILE=1.
+ */
+int thread_lock_profile_enable(int enable);
+int thread_lock_profile_get(const thread_mutex_t *mutex, thread_lock_profile_t *profile);
+void thread_lock_profile_report(FILE *out);
+
+/* Verrous lecteurs-rédacteurs
+ * Plusieurs lecteurs peuvent détenir le verrou ensemble, un rédacteur le
+ * détient seul ; les threads qui ne peuvent pas l'obtenir se bloquent dans sa
+ * file d'attente. Par défaut les lecteurs entrent tant qu'aucun rédacteur ne
+ * détient le verrou ; avec THREAD_RWLOCK_PREFER_WRITER, un rédacteur en
+ * attente bloque les nouveaux lecteurs et passe avant les lecteurs en attente.
+ * Chaque worker compte ses lecteurs dans sa propre ligne de cache : les
+ * lecteurs de workers différents n'écrivent jamais dans la même.
+ */
+#define THREAD_RWLOCK_PREFER_READER 0
+#define THREAD_RWLOCK_PREFER_WRITER 1
+#define THREAD_RWLOCK_SLOTS 1   /* un indicateur de lecteurs par worker */
+
+typedef struct thread_rwlock {
+    struct {
+        unsigned long count;
+    } __attribute__((aligned(64))) readers[THREAD_RWLOCK_SLOTS];
+    thread_t writer;        /* rédacteur détenteur, NULL sinon */
+    thread_t waiters;       /* threads en attente, dans l'ordre d'arrivée */
+    int writers_waiting;    /* rédacteurs parmi eux */
+    int prefer;             /* THREAD_RWLOCK_PREFER_READER ou THREAD_RWLOCK_PREFER_WRITER */
+} thread_rwlock_t;
+
+int thread_rwlock_init(thread_rwlock_t *rwlock, int prefer);
+int thread_rwlock_destroy(thread_rwlock_t *rwlock);
+int thread_rwlock_rdlock(thread_rwlock_t *rwlock);
+int thread_rwlock_wrlock(thread_rwlock_t *rwlock);
+int thread_rwlock_unlock(thread_rwlock_t *rwlock);
+
+/* Attente sur une adresse
+ * thread_wait_on() bloque le thread courant tant que *addr vaut expected, et
+ * thread_wake() réveille des threads bloqués sur la même adresse. Les
+ * threads bloqués sont rangés dans une table de files indexée par adresse :
+ * une primitive de synchronisation n'a besoin que d'un entier, modifié par
+ * opérations atomiques, pour bloquer ses threads au lieu de les faire
+ * boucler sur thread_yield(). thread_wait_on() peut rendre la main sans
+ * changement de valeur : l'appelant relit *addr et attend à nouveau.
+ */
+#define THREAD_WAKE_ALL (-1)
+
+int thread_wait_on(const volatile int *addr, int expected);
+int thread_wake(const volatile int *addr, int n);
+
 /* Interface Sémaphore */
 struct thread_sem;
 typedef struct thread_sem *thread_sem_t;
@@ -75,6 +410,25 @@ int thread_cond_broadcast(thread_cond_t cond);
 int thread_cond_destroy(thread_cond_t *cond);
 
 
+/* Consommation mémoire de la bibliothèque.
+ * Les tailles sont en octets et correspondent à ce qui est réservé par la
+ * bibliothèque (piles, descripteurs de threads, objets de synchronisation),
+ * indépendamment de ce qui est réellement résident en mémoire.
+ */
+typedef struct thread_mem_stats {
+    size_t nb_threads;   /* nombre de threads vivants (non joints) */
+    size_t stacks;       /* piles des threads, pages de garde comprises */
+    size_t stacks_cached;/* piles libres conservées pour être réutilisées */
+    size_t descriptors;  /* struct thread et structures de signaux */
+    size_t descriptors_cached; /* descripteurs libres conservés pour être réutilisés */
+    size_t sync;         /* sémaphores, barrières et conditions */
+} thread_mem_stats_t;
+
+/* remplir *stats avec la consommation mémoire courante.
+ * renvoie 0 en cas de succès, -1 si stats est NULL.
+ */
+int thread_get_mem_stats(thread_mem_stats_t *stats);
+
 /* Signaux */
 typedef enum signals {  
         SIG_USER1=0,
@@ -123,9 +477,9 @@ void initializer(void)__attribute__((constructor));
 void cleaner(void)__attribute__((destructor));
 
 /**
- * Créer et initialiser un thread 
+ * Créer et initialiser un thread (attr peut être NULL)
  */
-struct thread * thread_init(void);
+struct thread * thread_init(const thread_attr_t *attr);
 
 /**
  *  Fonction pour récupérer le premier thread dans la file d'attente avec la priorité la plus haute
@@ -198,12 +552,12 @@ void timer_handler();
 void install_handler(void);
 
 /**
- * Permettre au thread de capturer le signal de préemption 
+ * Sortir d'une section critique ; la préemption différée est honorée en sortant de la dernière
  */
 void enable_interrupt(void);
 
 /**
- * Bloquer la capture du signal de préemption par le thread
+ * Entrer dans une section critique (imbricable) : la préemption est différée jusqu'à sa sortie
  */
 void disable_interrupt(void);
 
@@ -222,6 +576,13 @@ struct thread *get_thread_multicore(void);
 #define thread_join pthread_join
 #define thread_exit pthread_exit
 
+/* Données propres à chaque thread */
+#define thread_key_t        pthread_key_t
+#define thread_key_create   pthread_key_create
+#define thread_key_delete   pthread_key_delete
+#define thread_getspecific  pthread_getspecific
+#define thread_setspecific  pthread_setspecific
+
 /* Interface possible pour les mutex */
 #define thread_mutex_t            pthread_mutex_t
 #define thread_mutex_init(_mutex) pthread_mutex_init(_mutex, NULL)
@@ -229,6 +590,16 @@ struct thread *get_thread_multicore(void);
 #define thread_mutex_lock         pthread_mutex_lock
 #define thread_mutex_unlock       pthread_mutex_unlock
 
+/* Verrous lecteurs-rédacteurs (la préférence est ignorée) */
+#define THREAD_RWLOCK_PREFER_READER 0
+#define THREAD_RWLOCK_PREFER_WRITER 1
+#define thread_rwlock_t                   pthread_rwlock_t
+#define thread_rwlock_init(_rwlock, _pref) pthread_rwlock_init(_rwlock, NULL)
+#define thread_rwlock_destroy             pthread_rwlock_destroy
+#define thread_rwlock_rdlock              pthread_rwlock_rdlock
+#define thread_rwlock_wrlock              pthread_rwlock_wrlock
+#define thread_rwlock_unlock              pthread_rwlock_unlock
+
 #endif /* USE_PTHREAD */
 
 #endif /* __THREAD_H__ */
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test des données propres aux threads.
+ *
+ * chaque thread range ses propres valeurs sous les mêmes clés, y compris
+ * au-delà des cases du descripteur, et ne voit jamais celles des autres.
+ * à la terminaison d'un thread, par retour ou par thread_exit(), le
+ * destructeur est appelé une fois par valeur non NULL, et de nouveau si un
+ * destructeur range une nouvelle valeur.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_exit()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_key_create(), thread_key_delete()
+ * - thread_getspecific(), thread_setspecific()
+ */
+
+#define NB 10
+#define NB_KEYS 20
+
+static thread_key_t keys[NB_KEYS], again;
+static int destroyed = 0, destroyed_again = 0;
+
+static void destroy(void *value)
+{
+  free(value);
+  destroyed++;
+}
+
+/* range une nouvelle valeur la première fois */
+static void destroy_again(void *value)
+{
+  destroyed_again++;
+  if (value == (void *) 1) {
+    thread_setspecific(again, (void *) 2);
+  }
+}
+
+static void * thfunc(void *arg)
+{
+  long id = (long) arg;
+  int err, i;
+
+  for (i = 0; i < NB_KEYS; i++) {
+    assert(thread_getspecific(keys[i]) == NULL);
+    int *value = malloc(sizeof(int));
+    assert(value);
+    *value = id * NB_KEYS + i;
+    err = thread_setspecific(keys[i], value);
+    assert(!err);
+    thread_yield();
+  }
+  for (i = 0; i < NB_KEYS; i++) {
+    int *value = thread_getspecific(keys[i]);
+    assert(value && *value == id * NB_KEYS + i);
+  }
+  /* valeur remise à NULL : pas de destructeur */
+  free(thread_getspecific(keys[0]));
+  thread_setspecific(keys[0], NULL);
+  thread_setspecific(again, (void *) 1);
+  if (id % 2) {
+    thread_exit(NULL);
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  thread_t th[NB];
+  int err, i;
+
+  for (i = 0; i < NB_KEYS; i++) {
+    err = thread_key_create(&keys[i], destroy);
+    assert(!err);
+  }
+  err = thread_key_create(&again, destroy_again);
+  assert(!err);
+
+  thread_setspecific(keys[NB_KEYS - 1], &err);
+  for (i = 0; i < NB; i++) {
+    err = thread_create(&th[i], thfunc, (void *) (long) i);
+    assert(!err);
+  }
+  for (i = 0; i < NB; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  /* le thread principal garde sa propre valeur */
+  assert(thread_getspecific(keys[NB_KEYS - 1]) == &err);
+  assert(thread_getspecific(keys[0]) == NULL);
+  assert(destroyed == NB * (NB_KEYS - 1));
+  assert(destroyed_again == 2 * NB);
+
+  thread_setspecific(keys[NB_KEYS - 1], NULL);
+  for (i = 0; i < NB_KEYS; i++) {
+    err = thread_key_delete(keys[i]);
+    assert(!err);
+  }
+  err = thread_key_delete(again);
+  assert(!err);
+
+  printf("%d valeurs détruites à la terminaison des threads\n", destroyed + destroyed_again);
+  return EXIT_SUCCESS;
+}
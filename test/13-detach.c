@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test des threads détachés.
+ *
+ * des threads créés détachés, ou détachés après leur création, se
+ * terminent sans jamais être joints : leurs ressources doivent être
+ * libérées automatiquement et aucun join ne doit être possible.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_attr_setdetachstate()
+ * - thread_create_attr()
+ * - thread_detach()
+ * - thread_yield()
+ * - thread_get_mem_stats()
+ */
+
+static int counter = 0;
+
+static void * thfunc(void *dummy __attribute__((unused)))
+{
+  thread_yield();
+  counter++;
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_attr_t attr;
+  thread_t th;
+  thread_mem_stats_t stats;
+  int err, i, nb = 1000;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+
+  thread_attr_init(&attr);
+  err = thread_attr_setdetachstate(&attr, THREAD_CREATE_DETACHED);
+  assert(!err);
+
+  for (i = 0; i < nb; i++) {
+    err = thread_create_attr(&th, &attr, thfunc, NULL);
+    assert(!err);
+  }
+  /* un thread détaché ne peut pas être joint */
+  assert(thread_join(th, NULL) != 0);
+
+  for (i = 0; i < nb; i++) {
+    err = thread_create(&th, thfunc, NULL);
+    assert(!err);
+    err = thread_detach(th);
+    assert(!err);
+    assert(thread_detach(th) != 0);
+  }
+
+  /* détacher un thread déjà terminé le libère immédiatement */
+  err = thread_create(&th, thfunc, NULL);
+  assert(!err);
+  while (counter < 2 * nb + 1)
+    thread_yield();
+  err = thread_detach(th);
+  assert(!err);
+
+  thread_get_mem_stats(&stats);
+  printf("%d threads détachés terminés, %zu thread(s) encore vivant(s)\n", counter, stats.nb_threads);
+  assert(counter == 2 * nb + 1);
+  assert(stats.nb_threads == 1);
+
+  thread_attr_destroy(&attr);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test de l'attente groupée de threads.
+ *
+ * le thread principal crée des threads qui passent la main un nombre
+ * variable de fois, puis les attend tous d'un coup, attend le premier
+ * terminé d'un groupe, et enfin utilise une portée qui joint
+ * automatiquement les threads qu'elle a créés.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_join_many(), thread_join_any()
+ * - thread_scope_init(), thread_scope_spawn(), thread_scope_join()
+ * - thread_yield()
+ * - thread_get_mem_stats()
+ */
+
+static int finished = 0;
+
+static void * thfunc(void *arg)
+{
+  unsigned long i, n = (unsigned long) arg;
+  for (i = 0; i < n; i++)
+    thread_yield();
+  finished++;
+  return (void *) (n * 2);
+}
+
+int main(int argc, char *argv[])
+{
+  thread_t *th;
+  void **res;
+  void *one;
+  thread_scope_t scope;
+  thread_mem_stats_t before, after;
+  int err, i, nb = 100;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+  th = malloc(nb * sizeof(*th));
+  res = malloc(nb * sizeof(*res));
+  assert(th && res);
+  thread_get_mem_stats(&before);
+
+  /* attente de tous les threads, dont certains déjà terminés */
+  for (i = 0; i < nb; i++) {
+    err = thread_create(&th[i], thfunc, (void *) (unsigned long) (i % 5));
+    assert(!err);
+  }
+  thread_yield();
+  err = thread_join_many(th, nb, res);
+  assert(!err);
+  assert(finished == nb);
+  for (i = 0; i < nb; i++)
+    assert((unsigned long) res[i] == 2 * (unsigned long) (i % 5));
+  printf("%d threads joints en une seule attente\n", nb);
+
+  /* attente du premier terminé : celui qui passe le moins la main */
+  for (i = 0; i < 3; i++) {
+    err = thread_create(&th[i], thfunc, (void *) (unsigned long) (10 - 4 * i));
+    assert(!err);
+  }
+  i = thread_join_any(th, 3, &one);
+  assert(i == 2);
+  assert((unsigned long) one == 4);
+  err = thread_join(th[0], &one);
+  assert(!err && (unsigned long) one == 20);
+  err = thread_join(th[1], &one);
+  assert(!err && (unsigned long) one == 12);
+  printf("premier thread terminé: %d\n", i);
+
+  /* portée : tous les threads créés sont joints à la sortie */
+  finished = 0;
+  err = thread_scope_init(&scope);
+  assert(!err);
+  for (i = 0; i < nb; i++) {
+    err = thread_scope_spawn(&scope, NULL, thfunc, (void *) (unsigned long) (i % 3));
+    assert(!err);
+  }
+  assert(scope.count == nb);
+  err = thread_scope_join(&scope);
+  assert(!err);
+  assert(finished == nb);
+  assert(scope.count == 0);
+
+  thread_get_mem_stats(&after);
+  assert(after.nb_threads == before.nb_threads);
+  free(th);
+  free(res);
+  printf("attente groupée OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include "thread.h"
+
+/* test du passage direct d'un thread qui se termine à son joiner.
+ *
+ * des threads passent la main en boucle pendant que le thread principal
+ * crée et attend plusieurs fois un thread. en FIFO, le thread principal
+ * doit reprendre juste après la terminaison du thread attendu, sans
+ * qu'aucun autre thread prêt ne s'exécute entre les deux (sauf préemption).
+ * la latence moyenne de reprise est affichée.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_create(), thread_yield()
+ * - thread_join() avec récupération de la valeur de retour
+ */
+
+static volatile int stop = 0;
+static unsigned long switches = 0;
+static unsigned long switches_at_exit;
+static struct timespec ts_exit;
+
+static void * spinner(void *dummy __attribute__((unused)))
+{
+  while (!stop) {
+    switches++;
+    thread_yield();
+  }
+  return NULL;
+}
+
+static void * target(void *arg)
+{
+  unsigned long i, n = (unsigned long) arg;
+  for (i = 0; i < n; i++)
+    thread_yield();
+  switches_at_exit = switches;
+  clock_gettime(CLOCK_MONOTONIC, &ts_exit);
+  return arg;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_t spinners[4], th;
+  struct timespec ts_join;
+  unsigned long latency = 0, direct = 0;
+  void *res;
+  int err, i, nb = 1000;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+  for (i = 0; i < 4; i++) {
+    err = thread_create(&spinners[i], spinner, NULL);
+    assert(!err);
+  }
+
+  for (i = 0; i < nb; i++) {
+    err = thread_create(&th, target, (void *) (unsigned long) (i % 4));
+    assert(!err);
+    err = thread_join(th, &res);
+    clock_gettime(CLOCK_MONOTONIC, &ts_join);
+    assert(!err);
+    assert((unsigned long) res == (unsigned long) (i % 4));
+    if (switches == switches_at_exit)
+      direct++;
+    latency += (ts_join.tv_sec - ts_exit.tv_sec) * 1000000000 + (ts_join.tv_nsec - ts_exit.tv_nsec);
+  }
+#if defined(FIFO) && !defined(PREEMPTION)
+  assert(direct == (unsigned long) nb);
+#elif defined(FIFO)
+  /* une préemption peut tomber entre la fin du thread attendu et sa terminaison */
+  assert(direct >= (unsigned long) nb / 2);
+#endif
+
+  stop = 1;
+  for (i = 0; i < 4; i++) {
+    err = thread_join(spinners[i], NULL);
+    assert(!err);
+  }
+  printf("%lu/%d reprises directes après terminaison, latence moyenne %lu ns\n",
+         direct, nb, latency / nb);
+  return EXIT_SUCCESS;
+}
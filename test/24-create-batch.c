@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* test de la création de threads par lot, puis plein de join quand ils ont tous fini
+ *
+ * chaque thread reçoit un élément différent d'un tableau d'arguments et
+ * renvoie son double. En FIFO, les threads doivent s'exécuter dans l'ordre du lot.
+ * valgrind doit etre content.
+ * la durée du programme doit etre proportionnelle au nombre de threads donnés en argument.
+ *
+ * support nécessaire:
+ * - thread_create_batch()
+ * - thread_join() avec récupération de la valeur de retour
+ */
+
+static int next = 0;
+
+static void * thfunc(void *arg)
+{
+  int value = *(int *) arg;
+#ifdef FIFO
+  assert(value == next);
+#endif
+  next++;
+  return (void *) (long) (value * 2);
+}
+
+int main(int argc, char *argv[])
+{
+  thread_t *th;
+  int *args;
+  int err, i, nb = 1000;
+  struct timeval tv1, tv2;
+  unsigned long us;
+  void *res;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+
+  th = malloc(nb*sizeof(*th));
+  args = malloc(nb*sizeof(*args));
+  if (!th || !args) {
+    perror("malloc");
+    return -1;
+  }
+  for(i=0; i<nb; i++)
+    args[i] = i;
+
+  gettimeofday(&tv1, NULL);
+  err = thread_create_batch(th, nb, thfunc, args, sizeof(*args));
+  assert(!err);
+  for(i=0; i<nb; i++) {
+    err = thread_join(th[i], &res);
+    assert(!err);
+    assert((long) res == 2 * i);
+  }
+  gettimeofday(&tv2, NULL);
+  assert(next == nb);
+
+  us = (tv2.tv_sec-tv1.tv_sec)*1000000+(tv2.tv_usec-tv1.tv_usec);
+  printf("%d threads créés par lot et détruits en %lu us\n", nb, us);
+
+  free(args);
+  free(th);
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* test des tâches sans pile.
+ *
+ * le thread principal soumet beaucoup de petites tâches puis les attend,
+ * et un thread soumet des tâches qui sont exécutées au changement de
+ * contexte suivant, avant même d'être attendues.
+ * la durée doit être proportionnelle au nombre de tâches données en argument.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_task_submit(), thread_task_join()
+ * - thread_create(), thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ */
+
+static unsigned long executed = 0;
+
+static void * square(void *arg)
+{
+  unsigned long value = (unsigned long) arg;
+  executed++;
+  return (void *) (value * value);
+}
+
+static void * submitter(void *arg)
+{
+  thread_job_t *jobs = arg;
+  int i;
+  void *res;
+
+  for (i = 0; i < 10; i++) {
+    jobs[i] = thread_task_submit(square, (void *) (unsigned long) i);
+    assert(jobs[i]);
+  }
+  /* le prochain changement de contexte exécute le lot */
+  executed = 0;
+  thread_yield();
+  assert(executed == 10);
+  for (i = 0; i < 10; i++) {
+    thread_task_join(jobs[i], &res);
+    assert((unsigned long) res == (unsigned long) (i * i));
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_job_t *jobs;
+  thread_t th;
+  struct timeval tv1, tv2;
+  unsigned long us;
+  int err, i, nb = 10000;
+  void *res;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+  jobs = malloc(nb * sizeof(*jobs));
+  assert(jobs);
+
+  gettimeofday(&tv1, NULL);
+  for (i = 0; i < nb; i++) {
+    jobs[i] = thread_task_submit(square, (void *) (unsigned long) i);
+    assert(jobs[i]);
+  }
+  for (i = 0; i < nb; i++) {
+    err = thread_task_join(jobs[i], &res);
+    assert(!err);
+    assert((unsigned long) res == (unsigned long) i * i);
+  }
+  gettimeofday(&tv2, NULL);
+  assert(executed == (unsigned long) nb);
+  us = (tv2.tv_sec-tv1.tv_sec)*1000000+(tv2.tv_usec-tv1.tv_usec);
+  printf("%d tâches exécutées en %lu us\n", nb, us);
+
+  err = thread_create(&th, submitter, jobs);
+  assert(!err);
+  err = thread_join(th, NULL);
+  assert(!err);
+
+  free(jobs);
+  printf("tâches sans pile OK\n");
+  return EXIT_SUCCESS;
+}
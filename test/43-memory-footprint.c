@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* mesure de l'empreinte mémoire des threads inactifs.
+ *
+ * on crée des threads qui ne seront ordonnancés qu'au moment du join,
+ * jusqu'à ce que la mémoire résidente consommée atteigne le budget donné
+ * en argument (en Mio, 64 par défaut) ou que le nombre maximal de threads
+ * (second argument) soit atteint.
+ * Le programme affiche ensuite le coût moyen d'un thread en mémoire
+ * virtuelle, résidente et en tas, ainsi que le détail fourni par la bibliothèque.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_join() sans récupération de la valeur de retour
+ * - retour sans thread_exit()
+ * - thread_get_mem_stats()
+ */
+
+static void * thfunc(void *dummy __attribute__((unused)))
+{
+  return NULL;
+}
+
+static void read_statm(size_t *vsize, size_t *rss)
+{
+  unsigned long pages_virt = 0, pages_res = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%lu %lu", &pages_virt, &pages_res) != 2) {
+      pages_virt = pages_res = 0;
+    }
+    fclose(f);
+  }
+  *vsize = pages_virt * sysconf(_SC_PAGESIZE);
+  *rss = pages_res * sysconf(_SC_PAGESIZE);
+}
+
+static size_t heap_usage(void)
+{
+  struct mallinfo2 mi = mallinfo2();
+  return mi.uordblks + mi.hblkhd;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_t *th = NULL;
+  int err, i, nb = 0, capacity = 0;
+  size_t budget = 64, max = 1 << 20;
+  size_t vsize0, rss0, heap0, vsize1, rss1, heap1;
+  struct timeval tv1, tv2;
+  unsigned long us;
+
+  if (argc >= 2) {
+    budget = atol(argv[1]);
+  }
+  if (argc >= 3) {
+    max = atol(argv[2]);
+  }
+  budget *= 1024 * 1024;
+
+  read_statm(&vsize0, &rss0);
+  heap0 = heap_usage();
+  rss1 = rss0;
+
+  gettimeofday(&tv1, NULL);
+  /* on cree des threads tant que le budget n'est pas atteint */
+  while ((size_t) nb < max && rss1 < rss0 + budget) {
+    if (nb == capacity) {
+      capacity = capacity ? 2 * capacity : 1024;
+      th = realloc(th, capacity * sizeof(*th));
+      if (!th) {
+        perror("realloc");
+        return -1;
+      }
+    }
+    err = thread_create(&th[nb], thfunc, NULL);
+    assert(!err);
+    nb++;
+    if (nb % 64 == 0) {
+      read_statm(&vsize1, &rss1);
+    }
+  }
+  gettimeofday(&tv2, NULL);
+  read_statm(&vsize1, &rss1);
+  heap1 = heap_usage();
+
+  us = (tv2.tv_sec-tv1.tv_sec)*1000000+(tv2.tv_usec-tv1.tv_usec);
+  printf("%d threads inactifs créés en %lu us\n", nb, us);
+  if (nb > 0) {
+    printf("par thread: %zu octets virtuels, %zu octets résidents, %zu octets de tas\n",
+           (vsize1 - vsize0) / nb, (rss1 - rss0) / nb, (heap1 - heap0) / nb);
+  }
+
+#ifndef USE_PTHREAD
+  thread_mem_stats_t stats;
+  err = thread_get_mem_stats(&stats);
+  assert(!err);
+  printf("bibliothèque: %zu threads, piles %zu o, descripteurs %zu o, synchronisation %zu o\n",
+         stats.nb_threads, stats.stacks, stats.descriptors, stats.sync);
+  if (stats.nb_threads > 0) {
+    printf("bibliothèque par thread: %zu octets\n",
+           (stats.stacks + stats.descriptors) / stats.nb_threads);
+  }
+#endif
+
+  /* on les joine tous */
+  for(i=0; i<nb; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+
+  free(th);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "thread.h"
+
+/* test des attributs de création de thread (taille de pile).
+ *
+ * un thread avec une grande pile effectue une récursion profonde qui
+ * déborderait de la pile par défaut, puis de nombreux threads sont créés
+ * avec une petite pile. Les piles libérées doivent être réutilisées.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_attr_init(), thread_attr_setstacksize(), thread_attr_getstacksize()
+ * - thread_create_attr()
+ * - thread_join() avec récupération de la valeur de retour
+ * - thread_get_mem_stats()
+ */
+
+static unsigned long recurse(unsigned long depth)
+{
+  unsigned char buffer[1024];
+  memset(buffer, (int) depth, sizeof(buffer));
+  if (depth == 0)
+    return buffer[0];
+  return buffer[sizeof(buffer) - 1] + recurse(depth - 1);
+}
+
+static void * deep(void *arg)
+{
+  return (void *) recurse((unsigned long) arg);
+}
+
+static void * small(void *arg)
+{
+  return (void *) ((unsigned long) arg * 2);
+}
+
+int main(int argc, char *argv[])
+{
+  thread_attr_t attr;
+  thread_t th, *ths;
+  void *res;
+  size_t size;
+  int err, i, nb = 1000;
+  unsigned long depth = 1000, expected = 0;
+  thread_mem_stats_t stats;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+
+  err = thread_attr_init(&attr);
+  assert(!err);
+  err = thread_attr_getstacksize(&attr, &size);
+  assert(!err);
+  printf("taille de pile par défaut: %zu octets\n", size);
+  assert(thread_attr_setstacksize(&attr, THREAD_STACK_MAX + 1) == -1);
+
+  /* récursion profonde sur une pile de 2 Mio */
+  err = thread_attr_setstacksize(&attr, 2 * 1024 * 1024);
+  assert(!err);
+  err = thread_create_attr(&th, &attr, deep, (void *) depth);
+  assert(!err);
+  err = thread_join(th, &res);
+  assert(!err);
+  for (i = (int) depth; i > 0; i--)
+    expected += (unsigned char) i;
+  assert((unsigned long) res == expected);
+  printf("récursion de profondeur %lu sur une pile de 2 Mio OK\n", depth);
+
+  /* beaucoup de threads avec une petite pile */
+  ths = malloc(nb * sizeof(*ths));
+  assert(ths);
+  err = thread_attr_setstacksize(&attr, THREAD_STACK_MIN);
+  assert(!err);
+  for (i = 0; i < nb; i++) {
+    err = thread_create_attr(&ths[i], &attr, small, (void *) (unsigned long) i);
+    assert(!err);
+  }
+  thread_get_mem_stats(&stats);
+  printf("%d threads à petite pile: %zu octets de pile au total\n", nb, stats.stacks);
+  for (i = 0; i < nb; i++) {
+    err = thread_join(ths[i], &res);
+    assert(!err);
+    assert((unsigned long) res == 2 * (unsigned long) i);
+  }
+  thread_get_mem_stats(&stats);
+  assert(stats.stacks_cached > 0);
+
+  /* les piles libérées sont réutilisées */
+  err = thread_create_attr(&th, &attr, small, (void *) 21);
+  assert(!err);
+  err = thread_join(th, &res);
+  assert(!err);
+  assert((unsigned long) res == 42);
+
+  thread_attr_destroy(&attr);
+  free(ths);
+  printf("attributs de pile OK\n");
+  return EXIT_SUCCESS;
+}
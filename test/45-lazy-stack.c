@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include "thread.h"
+
+/* test des piles réservées paresseusement.
+ *
+ * un thread utilise environ 512 Kio de sa pile par défaut (1 Mio réservé),
+ * ce qui fait monter la mémoire résidente. Après le join, la pile est
+ * recyclée et les pages au-delà du seuil de conservation doivent être
+ * rendues au système : la mémoire résidente doit redescendre.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_join() avec récupération de la valeur de retour
+ * - thread_set_stack_watermark()
+ */
+
+static size_t resident(void)
+{
+  unsigned long pages_virt = 0, pages_res = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%lu %lu", &pages_virt, &pages_res) != 2) {
+      pages_res = 0;
+    }
+    fclose(f);
+  }
+  return pages_res * sysconf(_SC_PAGESIZE);
+}
+
+static size_t peak;
+
+static unsigned long recurse(unsigned long depth)
+{
+  unsigned char buffer[1024];
+  memset(buffer, 1, sizeof(buffer));
+  if (depth == 0) {
+    peak = resident();
+    return buffer[0];
+  }
+  return buffer[sizeof(buffer) - 1] + recurse(depth - 1);
+}
+
+static void * deep(void *arg)
+{
+  return (void *) recurse((unsigned long) arg);
+}
+
+int main()
+{
+  thread_t th;
+  void *res;
+  size_t before, after;
+  int err;
+
+  err = thread_set_stack_watermark(16 * 1024);
+  assert(!err);
+  assert(thread_get_stack_watermark() == 16 * 1024);
+
+  before = resident();
+  err = thread_create(&th, deep, (void *) 480);
+  assert(!err);
+  err = thread_join(th, &res);
+  assert(!err);
+  assert((unsigned long) res == 481);
+  after = resident();
+
+  printf("mémoire résidente: avant %zu Kio, pendant %zu Kio, après %zu Kio\n",
+         before / 1024, peak / 1024, after / 1024);
+  assert(peak > before + 256 * 1024);
+  assert(after < peak - 256 * 1024);
+
+  /* la pile recyclée est de nouveau utilisable en entier */
+  err = thread_create(&th, deep, (void *) 480);
+  assert(!err);
+  err = thread_join(th, &res);
+  assert(!err);
+  assert((unsigned long) res == 481);
+
+  printf("piles paresseuses OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "thread.h"
+
+/* test du mode pile partagée.
+ *
+ * de nombreux threads en mode pile partagée remplissent un tableau local,
+ * passent la main plusieurs fois puis vérifient que leur pile a été
+ * correctement sauvegardée et restaurée. Des threads à pile dédiée sont
+ * mélangés aux autres. La mémoire de pile consommée doit rester faible.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_attr_setsharedstack()
+ * - thread_create_attr()
+ * - thread_yield()
+ * - thread_join() avec récupération de la valeur de retour
+ */
+
+static unsigned long checksum(unsigned char *buffer, int size)
+{
+  unsigned long sum = 0;
+  for (int i = 0; i < size; i++)
+    sum += buffer[i];
+  return sum;
+}
+
+static void * thfunc(void *arg)
+{
+  unsigned long id = (unsigned long) arg;
+  unsigned char buffer[256];
+  unsigned long expected;
+
+  memset(buffer, (int) id, sizeof(buffer));
+  expected = checksum(buffer, sizeof(buffer));
+  for (int i = 0; i < 5; i++) {
+    thread_yield();
+    assert(checksum(buffer, sizeof(buffer)) == expected);
+  }
+  return (void *) expected;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_attr_t shared;
+  thread_t *th;
+  thread_mem_stats_t stats;
+  void *res;
+  int err, i, nb = 10000;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+  th = malloc(nb * sizeof(*th));
+  assert(th);
+
+  thread_attr_init(&shared);
+  err = thread_attr_setsharedstack(&shared, 1);
+  assert(!err);
+
+  /* un thread sur seize a une pile dédiée */
+  for (i = 0; i < nb; i++) {
+    err = thread_create_attr(&th[i], i % 16 ? &shared : NULL, thfunc, (void *) (unsigned long) i);
+    assert(!err);
+  }
+
+  /* tous les threads ont commencé à s'exécuter */
+  for (i = 0; i < 3; i++)
+    thread_yield();
+
+  thread_get_mem_stats(&stats);
+  printf("%d threads: %zu octets de pile réservés\n", nb, stats.stacks);
+
+  for (i = 0; i < nb; i++) {
+    err = thread_join(th[i], &res);
+    assert(!err);
+    assert((unsigned long) res == 256 * (unsigned long) (unsigned char) i);
+  }
+
+  thread_attr_destroy(&shared);
+  free(th);
+  printf("pile partagée OK\n");
+  return EXIT_SUCCESS;
+}
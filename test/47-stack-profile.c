@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "thread.h"
+
+/* test du profilage des piles et de l'auto-ajustement de leur taille.
+ *
+ * des threads utilisant environ 8 Kio de pile sont mesurés, puis les
+ * threads suivants de la même fonction doivent recevoir une pile bien
+ * plus petite que la pile par défaut.
+ *
+ * support nécessaire:
+ * - thread_stack_autotune_enable()
+ * - thread_stack_profile_get()
+ * - thread_create()
+ * - thread_join() avec récupération de la valeur de retour
+ * - thread_get_mem_stats()
+ */
+
+static unsigned long recurse(int depth)
+{
+  unsigned char buffer[1024];
+  memset(buffer, 1, sizeof(buffer));
+  if (depth == 0)
+    return buffer[0];
+  return buffer[sizeof(buffer) - 1] + recurse(depth - 1);
+}
+
+static void * thfunc(void *arg)
+{
+  return (void *) recurse((int) (unsigned long) arg);
+}
+
+int main()
+{
+  thread_t th[16];
+  thread_stack_profile_t profile;
+  thread_mem_stats_t before, after;
+  void *res;
+  int err, i;
+
+  thread_stack_autotune_enable(1);
+  assert(thread_stack_profile_get(thfunc, &profile) == -1);
+
+  for (i = 0; i < 16; i++) {
+    err = thread_create(&th[i], thfunc, (void *) 7);
+    assert(!err);
+  }
+  for (i = 0; i < 16; i++) {
+    err = thread_join(th[i], &res);
+    assert(!err);
+    assert((unsigned long) res == 8);
+  }
+
+  err = thread_stack_profile_get(thfunc, &profile);
+  assert(!err);
+  printf("%lu threads mesurés: max %zu o, moyenne %zu o, taille choisie %zu o\n",
+         profile.samples, profile.max, profile.mean, profile.suggested);
+  assert(profile.samples == 16);
+  assert(profile.max >= 8 * 1024 && profile.max < 64 * 1024);
+  assert(profile.suggested > profile.max && profile.suggested < 1024 * 1024);
+
+  /* les threads suivants reçoivent la taille choisie */
+  thread_get_mem_stats(&before);
+  err = thread_create(&th[0], thfunc, (void *) 7);
+  assert(!err);
+  thread_get_mem_stats(&after);
+  assert(after.stacks - before.stacks <= profile.suggested + 4096);
+  err = thread_join(th[0], &res);
+  assert(!err);
+  assert((unsigned long) res == 8);
+
+  printf("profilage des piles OK\n");
+  return EXIT_SUCCESS;
+}
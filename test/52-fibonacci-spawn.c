@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* fibonacci avec spawn/sync.
+ *
+ * les enfants s'exécutent en ligne tant que la pile le permet : la durée
+ * doit être proche de celle d'une récursion séquentielle. On vérifie ensuite,
+ * sur un thread à petite pile et avec de grosses trames, que les enfants
+ * sont promus en threads lorsque la pile vient à manquer.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_spawn(), thread_sync()
+ * - thread_attr_setstacksize(), thread_create_attr()
+ * - thread_join() avec récupération de la valeur de retour
+ */
+
+static void * fibo(void *_value)
+{
+  thread_task_t tasks[2];
+  int err;
+  unsigned long value = (unsigned long) _value;
+
+  if (value < 3)
+    return (void*) 1;
+
+  err = thread_spawn(&tasks[0], fibo, (void*)(value-1));
+  assert(!err);
+  err = thread_spawn(&tasks[1], fibo, (void*)(value-2));
+  assert(!err);
+  err = thread_sync(tasks, 2);
+  assert(!err);
+
+  return (void*)((unsigned long) tasks[0].retval + (unsigned long) tasks[1].retval);
+}
+
+static int promoted = 0;
+
+struct deep_arg {
+  unsigned long depth;
+  thread_t parent;
+};
+
+static void * deep(void *_arg)
+{
+  struct deep_arg *arg = _arg, child;
+  thread_task_t task;
+  char frame[8 * 1024];
+  int err;
+
+  if (thread_self() != arg->parent)
+    promoted++;
+  memset(frame, (int) arg->depth, sizeof(frame));
+  if (arg->depth == 0)
+    return (void *) 1;
+
+  child.depth = arg->depth - 1;
+  child.parent = thread_self();
+  err = thread_spawn(&task, deep, &child);
+  assert(!err);
+  err = thread_sync(&task, 1);
+  assert(!err);
+  return (void *) ((unsigned long) task.retval + (frame[sizeof(frame) - 1] != 0));
+}
+
+unsigned long fibo_checker( unsigned long n )
+{
+  unsigned long a = 1;
+  unsigned long b = 1;
+  unsigned long c, i;
+
+  if ( n <= 2 ) {
+    return 1;
+  }
+
+  for( i=2; i<n; i++ ) {
+    c = a + b;
+    a = b;
+    b = c;
+  }
+  return c;
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long value = 25, res;
+  struct timeval tv1, tv2;
+  struct deep_arg arg;
+  thread_attr_t attr;
+  thread_t th;
+  void *ret;
+  double s;
+  int err;
+
+  if (argc >= 2) {
+    value = atoi(argv[1]);
+  }
+
+  gettimeofday(&tv1, NULL);
+  res = (unsigned long) fibo((void *)value);
+  gettimeofday(&tv2, NULL);
+  s = (tv2.tv_sec-tv1.tv_sec) + (tv2.tv_usec-tv1.tv_usec) * 1e-6;
+  if ( res != fibo_checker( value ) ) {
+    printf("fibo de %lu != %lu (FAILED)\n", value, fibo_checker( value ) );
+    return EXIT_FAILURE;
+  }
+  printf("fibo de %lu = %lu en %e s\n", value, res, s );
+
+  /* 64 niveaux de 8 Kio ne tiennent pas sur une pile de 128 Kio */
+  thread_attr_init(&attr);
+  thread_attr_setstacksize(&attr, 128 * 1024);
+  arg.depth = 64;
+  err = thread_create_attr(&th, &attr, deep, &arg);
+  assert(!err);
+  arg.parent = th;
+  err = thread_join(th, &ret);
+  assert(!err);
+  assert((unsigned long) ret == 64 + 1);
+  printf("%d enfants promus en threads\n", promoted);
+  assert(promoted > 0);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include "thread.h"
+
+#ifndef USE_PTHREAD
+
+/* test de l'attente sur une adresse.
+ *
+ * thread_wait_on() ne bloque pas si la valeur a déjà changé. Un thread
+ * bloqué ne s'exécute plus tant qu'un thread_wake() ne vise pas son adresse,
+ * même si une autre adresse de la même file est réveillée. Les threads sont
+ * réveillés au plus n à la fois et, en FIFO, s'exécutent dans l'ordre d'arrivée.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_wait_on(), thread_wake()
+ * - thread_sched_adaptive_enable()
+ */
+
+#define NB 4
+
+/* 64 files choisies par (adresse >> 2) % 64 : words[0] et words[64] partagent la même */
+static int words[65];
+static int *flag = &words[0], *other = &words[64];
+static int order[NB], pos = 0;
+static volatile int runs = 0;
+
+static void * waiter(void *arg)
+{
+  while (*flag == 0) {
+    runs++;
+    thread_wait_on(flag, 0);
+  }
+  order[pos++] = (int) (long) arg;
+  return NULL;
+}
+
+static void * waiter_other(void *arg __attribute__((unused)))
+{
+  while (*other == 0) {
+    thread_wait_on(other, 0);
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  thread_t th[NB], th_other;
+  int err, i;
+
+  /* l'ordre de réveil ne doit pas dépendre de la classe des threads */
+  thread_sched_adaptive_enable(0);
+  assert(thread_wait_on(flag, 1) == EAGAIN);
+  assert(thread_wake(flag, THREAD_WAKE_ALL) == 0);
+
+  for (i = 0; i < NB; i++) {
+    err = thread_create(&th[i], waiter, (void *) (long) i);
+    assert(!err);
+  }
+  err = thread_create(&th_other, waiter_other, NULL);
+  assert(!err);
+  for (i = 0; i < 10; i++) {
+    thread_yield();
+  }
+  /* bloqués : ils ne tournent plus */
+  assert(runs == NB);
+
+  /* un réveil sur l'autre adresse ne concerne pas les threads de flag */
+  *other = 1;
+  assert(thread_wake(other, THREAD_WAKE_ALL) == 1);
+  err = thread_join(th_other, NULL);
+  assert(!err);
+  assert(runs == NB && pos == 0);
+
+  /* réveil sans changement de valeur : le thread se bloque à nouveau */
+  assert(thread_wake(flag, 1) == 1);
+  thread_yield();
+  assert(runs == NB + 1 && pos == 0);
+
+  *flag = 1;
+  assert(thread_wake(flag, 2) == 2);
+  assert(thread_wake(flag, THREAD_WAKE_ALL) == NB - 2);
+  for (i = 0; i < NB; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  assert(pos == NB);
+#ifdef FIFO
+  for (i = 0; i < NB - 1; i++) {
+    assert(order[i] == i + 1);
+  }
+  assert(order[NB - 1] == 0);
+#endif
+
+  printf("attente sur une adresse OK\n");
+  return EXIT_SUCCESS;
+}
+
+#else
+
+int main() {
+    return 0;
+}
+
+#endif
@@ -8,12 +8,14 @@
 
 thread_mutex_t mutex;
 thread_cond_t cond;
+int waiting = 0;
 
 void* thread_func(void* arg){
     printf("Thread %ld started\n", (long) arg);
     thread_mutex_lock(&mutex);
     printf("Thread %ld acquired lock\n", (long) arg);
     printf("Thread %ld sleeping for 3 seconds\n", (long) arg);
+    waiting++;
     thread_cond_wait(cond, &mutex);
     printf("Thread %ld woke up\n", (long) arg);
     thread_mutex_unlock(&mutex);
@@ -31,7 +33,10 @@ int main(){
         thread_create(&threads[i], thread_func, (void*)((intptr_t)i));
     }
 
-    thread_yield();
+    /* selon l'ordonnancement, un seul passage ne suffit pas à ce que tous attendent */
+    while (waiting < 5) {
+        thread_yield();
+    }
     printf("Main thread signaling waiting threads\n");
     thread_cond_broadcast(cond);
 
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "thread.h"
 
 #ifndef USE_PTHREAD
@@ -10,7 +11,7 @@
 thread_barrier_t barrier;
 
 void* thread_func(void* arg) {
-    int id = (int)arg;
+    int id = (int)(intptr_t)arg;
     for(int i = 0; i < BARRIER_COUNT; i++) {
         printf("Thread %d before barrier %d\n", id, i);
         thread_barrier_wait(barrier);
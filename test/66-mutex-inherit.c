@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include "thread.h"
+
+/* test de la file d'attente des mutex et de l'héritage de priorité.
+ *
+ * le détenteur d'un mutex peut passer la main dans sa section critique :
+ * les threads qui veulent le mutex s'y bloquent, puis le reçoivent chacun
+ * leur tour. Avec l'ordonnancement par priorité (-DPRIORITY), le détenteur
+ * hérite de la priorité d'un thread plus prioritaire bloqué sur le mutex,
+ * et la retrouve en le relâchant.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_create(), thread_create_attr(), thread_attr_setpriority()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_mutex_lock(), thread_mutex_unlock()
+ * - thread_get_priority()
+ */
+
+#define NB 5
+
+static thread_mutex_t mutex;
+static int order[NB], pos = 0;
+static volatile int started = 0;
+
+static void * locker(void *arg)
+{
+  started++;
+  thread_mutex_lock(&mutex);
+  order[pos++] = (int) (long) arg;
+  /* les autres restent bloqués pendant ce passage de main */
+  thread_yield();
+  thread_mutex_unlock(&mutex);
+  return NULL;
+}
+
+int main(void)
+{
+  thread_t th[NB];
+  int err, i;
+
+  err = thread_mutex_init(&mutex);
+  assert(!err);
+
+  /* file d'attente : chacun reçoit le mutex à son tour */
+  thread_mutex_lock(&mutex);
+  for (i = 0; i < NB; i++) {
+    err = thread_create(&th[i], locker, (void *) (long) i);
+    assert(!err);
+  }
+  while (started < NB) {
+    thread_yield();
+  }
+  assert(pos == 0);
+  assert(thread_mutex_lock(&mutex) == EDEADLK);
+  assert(thread_mutex_destroy(&mutex) == -1);
+  thread_mutex_unlock(&mutex);
+  assert(thread_mutex_unlock(&mutex) == -1);
+  for (i = 0; i < NB; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  assert(pos == NB);
+#ifndef PRIORITY
+  for (i = 0; i < NB; i++) {
+    assert(order[i] == i);
+  }
+#else
+  {
+    thread_attr_t attr;
+    int base;
+
+    /* héritage : un thread plus prioritaire se bloque sur notre mutex */
+    started = 0;
+    thread_mutex_lock(&mutex);
+    base = thread_get_priority(thread_self());
+    thread_attr_init(&attr);
+    thread_attr_setpriority(&attr, 9);
+    err = thread_create_attr(&th[0], &attr, locker, (void *) 0L);
+    assert(!err);
+    while (!started) {
+      thread_yield();
+    }
+    assert(thread_get_priority(thread_self()) == thread_get_priority(th[0]));
+    assert(thread_get_priority(thread_self()) > base);
+    thread_mutex_unlock(&mutex);
+    assert(thread_get_priority(thread_self()) <= base);
+    err = thread_join(th[0], NULL);
+    assert(!err);
+  }
+#endif
+  err = thread_mutex_destroy(&mutex);
+  assert(!err);
+
+  printf("file d'attente des mutex OK\n");
+  return EXIT_SUCCESS;
+}
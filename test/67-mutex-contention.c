@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* mesure du coût des mutex, avec et sans contention.
+ *
+ * le thread principal prend et relâche un mutex libre en boucle, puis des
+ * threads incrémentent un compteur partagé en passant parfois la main dans
+ * la section critique, comme dans 61-mutex et 62-mutex, ce qui oblige les
+ * autres à attendre le mutex. Les durées sont affichées.
+ * Le résultat doit être égal au nombre de threads * 1000.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_mutex_init(), thread_mutex_destroy()
+ * - thread_mutex_lock(), thread_mutex_unlock()
+ */
+
+#define NB_ITER 1000
+
+static thread_mutex_t lock;
+static long counter = 0;
+
+static void * thfunc(void *arg __attribute__((unused)))
+{
+  int i;
+
+  for (i = 0; i < NB_ITER; i++) {
+    thread_mutex_lock(&lock);
+    counter++;
+    if (i % 8 == 0) {
+      thread_yield();
+    }
+    thread_mutex_unlock(&lock);
+    if (i % 3 == 0) {
+      thread_yield();
+    }
+  }
+  return NULL;
+}
+
+static unsigned long elapsed_us(struct timeval *tv1, struct timeval *tv2)
+{
+  return (tv2->tv_sec-tv1->tv_sec)*1000000+(tv2->tv_usec-tv1->tv_usec);
+}
+
+int main(int argc, char *argv[])
+{
+  struct timeval tv1, tv2;
+  thread_t *th;
+  int err, i, nb = 20;
+  long n = 10000000;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+  th = malloc(nb * sizeof(*th));
+  assert(th);
+  err = thread_mutex_init(&lock);
+  assert(!err);
+
+  /* sans contention */
+  gettimeofday(&tv1, NULL);
+  for (i = 0; i < n; i++) {
+    thread_mutex_lock(&lock);
+    thread_mutex_unlock(&lock);
+  }
+  gettimeofday(&tv2, NULL);
+  printf("%ld lock/unlock sans contention en %lu us\n", n, elapsed_us(&tv1, &tv2));
+
+  /* avec contention */
+  gettimeofday(&tv1, NULL);
+  for (i = 0; i < nb; i++) {
+    err = thread_create(&th[i], thfunc, NULL);
+    assert(!err);
+  }
+  for (i = 0; i < nb; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  gettimeofday(&tv2, NULL);
+  assert(counter == (long) nb * NB_ITER);
+  printf("%d threads * %d lock/unlock avec contention en %lu us\n", nb, NB_ITER, elapsed_us(&tv1, &tv2));
+
+  err = thread_mutex_destroy(&lock);
+  assert(!err);
+  free(th);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include "thread.h"
+
+/* test des verrous lecteurs-rédacteurs.
+ *
+ * des lecteurs qui passent la main en détenant le verrou doivent s'y
+ * retrouver ensemble, alors qu'un rédacteur est toujours seul.
+ * Avec la préférence rédacteurs, un lecteur arrivé après un rédacteur en
+ * attente doit passer après lui ; avec la préférence lecteurs, avant.
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_rwlock_init(), thread_rwlock_destroy()
+ * - thread_rwlock_rdlock(), thread_rwlock_wrlock(), thread_rwlock_unlock()
+ */
+
+#define NB 8
+
+static thread_rwlock_t rwlock;
+static int readers = 0, max_readers = 0, writers = 0;
+static int order[2], pos = 0;
+
+static void * reader(void *arg __attribute__((unused)))
+{
+  int i;
+
+  for (i = 0; i < 10; i++) {
+    thread_rwlock_rdlock(&rwlock);
+    assert(writers == 0);
+    if (++readers > max_readers) {
+      max_readers = readers;
+    }
+    thread_yield();
+    readers--;
+    thread_rwlock_unlock(&rwlock);
+  }
+  return NULL;
+}
+
+static void * writer(void *arg __attribute__((unused)))
+{
+  int i;
+
+  for (i = 0; i < 10; i++) {
+    thread_rwlock_wrlock(&rwlock);
+    assert(readers == 0 && writers == 0);
+    writers++;
+    thread_yield();
+    writers--;
+    thread_rwlock_unlock(&rwlock);
+    thread_yield();
+  }
+  return NULL;
+}
+
+static void * ordered(void *arg)
+{
+  int write = (int) (long) arg;
+
+  if (write) {
+    thread_rwlock_wrlock(&rwlock);
+  } else {
+    thread_rwlock_rdlock(&rwlock);
+  }
+  order[pos++] = write;
+  thread_rwlock_unlock(&rwlock);
+  return NULL;
+}
+
+/* main détient le verrou en lecture quand arrivent un rédacteur puis un lecteur */
+static void preference(int prefer, int first)
+{
+  thread_t w, r;
+  int err;
+
+  pos = 0;
+  err = thread_rwlock_init(&rwlock, prefer);
+  assert(!err);
+  thread_rwlock_rdlock(&rwlock);
+  err = thread_create(&w, ordered, (void *) 1L);
+  assert(!err);
+  thread_yield();
+  err = thread_create(&r, ordered, (void *) 0L);
+  assert(!err);
+  thread_yield();
+  thread_rwlock_unlock(&rwlock);
+  err = thread_join(w, NULL);
+  assert(!err);
+  err = thread_join(r, NULL);
+  assert(!err);
+  assert(pos == 2 && order[0] == first && order[1] == !first);
+  err = thread_rwlock_destroy(&rwlock);
+  assert(!err);
+}
+
+int main(void)
+{
+  thread_t th[NB];
+  int err, i;
+
+  assert(thread_rwlock_init(&rwlock, 2) == -1);
+  err = thread_rwlock_init(&rwlock, THREAD_RWLOCK_PREFER_READER);
+  assert(!err);
+  assert(thread_rwlock_unlock(&rwlock) == -1);
+  thread_rwlock_wrlock(&rwlock);
+  assert(thread_rwlock_wrlock(&rwlock) == EDEADLK);
+  assert(thread_rwlock_destroy(&rwlock) == -1);
+  thread_rwlock_unlock(&rwlock);
+
+  /* lecteurs ensemble, rédacteurs seuls */
+  for (i = 0; i < NB; i++) {
+    err = thread_create(&th[i], i % 4 == 0 ? writer : reader, NULL);
+    assert(!err);
+  }
+  for (i = 0; i < NB; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  assert(max_readers > 1);
+  assert(readers == 0 && writers == 0);
+  err = thread_rwlock_destroy(&rwlock);
+  assert(!err);
+
+  preference(THREAD_RWLOCK_PREFER_READER, 0);
+  preference(THREAD_RWLOCK_PREFER_WRITER, 1);
+
+  printf("verrous lecteurs-rédacteurs OK (jusqu'à %d lecteurs ensemble)\n", max_readers);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test du profilage de la contention des mutex.
+ *
+ * un mutex initialisé avant l'activation du profilage n'est pas suivi. Les
+ * mutex initialisés au même endroit partagent leurs statistiques : chaque
+ * acquisition est comptée, et celles où un thread a dû attendre le mutex,
+ * détenu par un thread qui passe la main, sont comptées avec attente.
+ * Le rapport est affiché sur la sortie standard.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_mutex_init(), thread_mutex_lock(), thread_mutex_unlock()
+ * - thread_lock_profile_enable(), thread_lock_profile_get(), thread_lock_profile_report()
+ */
+
+#define NB 4
+#define NB_ITER 10
+
+static thread_mutex_t mutexes[2];
+
+static void * thfunc(void *arg __attribute__((unused)))
+{
+  int i;
+
+  for (i = 0; i < NB_ITER; i++) {
+    thread_mutex_lock(&mutexes[0]);
+    thread_yield();
+    thread_mutex_unlock(&mutexes[0]);
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  thread_lock_profile_t profile, other;
+  thread_mutex_t untracked;
+  thread_t th[NB];
+  int err, i;
+
+  thread_lock_profile_enable(0);
+  thread_mutex_init(&untracked);
+  assert(thread_lock_profile_get(&untracked, &profile) == -1);
+
+  err = thread_lock_profile_enable(1);
+  assert(!err);
+  for (i = 0; i < 2; i++) {
+    thread_mutex_init(&mutexes[i]);
+  }
+
+  /* sans contention */
+  thread_mutex_lock(&mutexes[1]);
+  thread_mutex_unlock(&mutexes[1]);
+  err = thread_lock_profile_get(&mutexes[1], &profile);
+  assert(!err);
+  assert(profile.mutexes == 2);
+  assert(profile.acquisitions == 1 && profile.contended == 0 && profile.wait_total == 0);
+
+  /* avec contention */
+  for (i = 0; i < NB; i++) {
+    err = thread_create(&th[i], thfunc, NULL);
+    assert(!err);
+  }
+  for (i = 0; i < NB; i++) {
+    err = thread_join(th[i], NULL);
+    assert(!err);
+  }
+  err = thread_lock_profile_get(&mutexes[0], &profile);
+  assert(!err);
+  err = thread_lock_profile_get(&mutexes[1], &other);
+  assert(!err);
+  assert(profile.site == other.site);
+  assert(profile.acquisitions == 1 + NB * NB_ITER);
+  assert(profile.contended > 0 && profile.contended < profile.acquisitions);
+  assert(profile.wait_total > 0 && profile.wait_max <= profile.wait_total);
+  assert(profile.hold_total > 0);
+
+  thread_lock_profile_report(stdout);
+  thread_lock_profile_enable(0);
+  for (i = 0; i < 2; i++) {
+    err = thread_mutex_destroy(&mutexes[i]);
+    assert(!err);
+  }
+  thread_mutex_destroy(&untracked);
+  return EXIT_SUCCESS;
+}
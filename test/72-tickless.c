@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* test de la préemption sans tick inutile.
+ *
+ * le timer de préemption ne doit être armé que lorsque plusieurs threads
+ * sont prêts : seul, le thread principal peut passer la main autant qu'il
+ * veut sans timer, un thread qui tourne sans jamais passer la main doit
+ * être préempté, et le timer est désarmé une fois ce thread terminé.
+ * les passages de main sans autre thread ne doivent faire aucun appel système.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_get_sched_stats()
+ * - préemption
+ */
+
+static volatile int stop = 0;
+
+static int timer_armed(void)
+{
+  thread_sched_stats_t stats;
+  thread_get_sched_stats(&stats);
+  return stats.timeslice != 0;
+}
+
+static void * spin(void *arg __attribute__((unused)))
+{
+  while (!stop) {
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_t th;
+  thread_sched_stats_t before, after;
+  int err, i, nb = 100000;
+  struct timeval tv1, tv2;
+  unsigned long us;
+
+  if (argc >= 2) {
+    nb = atoi(argv[1]);
+  }
+
+  thread_get_sched_stats(&before);
+  gettimeofday(&tv1, NULL);
+  for (i = 0; i < nb; i++) {
+    thread_yield();
+  }
+  gettimeofday(&tv2, NULL);
+  thread_get_sched_stats(&after);
+  assert(after.timer_updates == before.timer_updates);
+  us = (tv2.tv_sec-tv1.tv_sec)*1000000+(tv2.tv_usec-tv1.tv_usec);
+  printf("%d yield sans autre thread en %lu us\n", nb, us);
+  assert(!timer_armed());
+
+#ifdef PREEMPTION
+  err = thread_create(&th, spin, NULL);
+  assert(!err);
+  assert(timer_armed());
+  /* le thread ne rend jamais la main : seule la préemption nous fait revenir */
+  thread_yield();
+  thread_get_sched_stats(&after);
+  assert(after.preemptions > before.preemptions);
+  stop = 1;
+  err = thread_join(th, NULL);
+  assert(!err);
+  thread_yield();
+  assert(!timer_armed());
+  printf("préemption sans tick OK\n");
+#else
+  (void) th;
+  (void) err;
+  (void) spin;
+#endif
+  return EXIT_SUCCESS;
+}
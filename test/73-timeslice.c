@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test des tranches de temps configurables.
+ *
+ * la tranche par défaut est modifiée à l'exécution, puis un thread créé
+ * avec sa propre tranche, plus courte, vérifie que c'est bien elle qui est
+ * programmée pendant qu'il s'exécute, et la tranche par défaut lorsque le
+ * thread principal reprend la main.
+ *
+ * support nécessaire:
+ * - thread_set_timeslice(), thread_get_timeslice()
+ * - thread_attr_settimeslice(), thread_create_attr()
+ * - thread_get_sched_stats()
+ * - thread_yield()
+ * - thread_join() avec récupération de la valeur de retour
+ */
+
+static void * latency(void *arg __attribute__((unused)))
+{
+  thread_sched_stats_t stats;
+  thread_get_sched_stats(&stats);
+  assert(thread_get_timeslice(thread_self()) == 1000);
+  return (void *) stats.timeslice;
+}
+
+int main()
+{
+  thread_attr_t attr;
+  thread_sched_stats_t stats;
+  thread_t th;
+  void *res;
+  int err;
+
+  printf("tranche par défaut: %lu us\n", thread_get_timeslice(NULL));
+  /* tranches fixes : pas d'ajustement d'après le comportement des threads */
+  thread_sched_adaptive_enable(0);
+  assert(thread_set_timeslice(NULL, 1) == -1);
+  err = thread_set_timeslice(NULL, 20000);
+  assert(!err);
+  assert(thread_get_timeslice(NULL) == 20000);
+  assert(thread_get_timeslice(thread_self()) == 20000);
+
+  thread_attr_init(&attr);
+  err = thread_attr_settimeslice(&attr, 1000);
+  assert(!err);
+  err = thread_create_attr(&th, &attr, latency, NULL);
+  assert(!err);
+  thread_yield();
+  err = thread_join(th, &res);
+  assert(!err);
+#ifdef PREEMPTION
+  assert((unsigned long) res == 1000);
+
+  /* le thread principal retrouve la tranche par défaut */
+  err = thread_create(&th, latency, NULL);
+  assert(!err);
+  thread_get_sched_stats(&stats);
+  assert(stats.timeslice == 20000);
+  err = thread_set_timeslice(th, 1000);
+  assert(!err);
+  thread_yield();
+  err = thread_join(th, &res);
+  assert(!err);
+  assert((unsigned long) res == 1000);
+#else
+  (void) stats;
+#endif
+
+  printf("tranches de temps OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include "thread.h"
+
+/* test des sections critiques sans préemption.
+ *
+ * le thread principal tourne plusieurs tranches de temps dans une section
+ * critique (imbriquée) pendant qu'un autre thread est prêt : ce dernier ne
+ * doit pas s'exécuter avant la sortie de la section la plus externe, où le
+ * tick différé fait aussitôt passer la main.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_join() sans récupération de la valeur de retour
+ * - disable_interrupt(), enable_interrupt()
+ * - thread_get_sched_stats()
+ * - préemption
+ */
+
+static volatile int ran = 0;
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void * witness(void *arg __attribute__((unused)))
+{
+  ran = 1;
+  return NULL;
+}
+
+int main(void)
+{
+  thread_sched_stats_t before, after;
+  thread_t th;
+  double start;
+  int err;
+
+  err = thread_create(&th, witness, NULL);
+  assert(!err);
+
+  thread_get_sched_stats(&before);
+  disable_interrupt();
+  disable_interrupt();
+  /* plusieurs tranches de temps sans passer la main */
+  start = cpu_time();
+  while (cpu_time() - start < 5 * before.timeslice * 1e-6) {
+  }
+  enable_interrupt();
+  assert(!ran);
+  thread_get_sched_stats(&after);
+  assert(after.preemptions == before.preemptions);
+  enable_interrupt();
+#ifdef PREEMPTION
+  /* le tick différé a été honoré en sortant de la section externe */
+  assert(ran);
+  thread_get_sched_stats(&after);
+  assert(after.preemptions == before.preemptions + 1);
+#endif
+
+  err = thread_join(th, NULL);
+  assert(!err);
+  printf("section critique sans préemption OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "thread.h"
+
+/* test des tranches de temps adaptatives.
+ *
+ * un thread qui tourne sans jamais passer la main doit être classé
+ * calculatoire et recevoir une tranche plus longue, un thread qui passe
+ * souvent la main doit être classé interactif et recevoir une tranche plus
+ * courte. Un thread interactif réveillé par une condition doit s'exécuter
+ * avant les threads déjà prêts.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_mutex_lock(), thread_cond_wait(), thread_cond_signal()
+ * - thread_get_sched_class(), thread_get_timeslice(), thread_get_sched_stats()
+ * - préemption
+ */
+
+static volatile int stop = 0;
+static volatile int waiting = 0;
+static int order[2], pos = 0;
+static thread_mutex_t mutex;
+static thread_cond_t cond;
+
+static void * cpu(void *arg __attribute__((unused)))
+{
+  while (!stop) {
+  }
+  return NULL;
+}
+
+static void * interactive(void *arg __attribute__((unused)))
+{
+  int i;
+  for (i = 0; i < 20; i++) {
+    thread_yield();
+  }
+  return NULL;
+}
+
+static void * waiter(void *arg __attribute__((unused)))
+{
+  int i;
+  for (i = 0; i < 4; i++) {
+    thread_yield();
+  }
+  thread_mutex_lock(&mutex);
+  waiting = 1;
+  thread_cond_wait(cond, &mutex);
+  order[pos++] = 1;
+  thread_mutex_unlock(&mutex);
+  return NULL;
+}
+
+static void * other(void *arg __attribute__((unused)))
+{
+  order[pos++] = 2;
+  return NULL;
+}
+
+int main(void)
+{
+  thread_sched_stats_t before, after;
+  thread_t th, th2;
+  unsigned long slice;
+  int err;
+
+  err = thread_set_timeslice(NULL, 1000);
+  assert(!err);
+  slice = thread_get_timeslice(NULL);
+
+#ifdef PREEMPTION
+  err = thread_create(&th, cpu, NULL);
+  assert(!err);
+  err = thread_create(&th2, interactive, NULL);
+  assert(!err);
+  /* chaque passage de main de th2 laisse th tourner jusqu'au tick */
+  while (thread_get_sched_class(th2) != THREAD_SCHED_INTERACTIVE
+         || thread_get_sched_class(th) != THREAD_SCHED_CPU) {
+    thread_yield();
+  }
+  assert(thread_get_timeslice(th) == 2 * slice);
+  assert(thread_get_timeslice(th2) == slice / 2);
+  stop = 1;
+  err = thread_join(th2, NULL);
+  assert(!err);
+  err = thread_join(th, NULL);
+  assert(!err);
+#else
+  (void) cpu;
+  (void) interactive;
+#endif
+
+  /* réveil d'un thread interactif */
+  thread_mutex_init(&mutex);
+  thread_cond_init(&cond);
+  err = thread_create(&th, waiter, NULL);
+  assert(!err);
+  while (!waiting) {
+    thread_yield();
+  }
+  assert(thread_get_sched_class(th) == THREAD_SCHED_INTERACTIVE);
+  err = thread_create(&th2, other, NULL);
+  assert(!err);
+  thread_get_sched_stats(&before);
+  thread_mutex_lock(&mutex);
+  thread_cond_signal(cond);
+  thread_mutex_unlock(&mutex);
+  thread_get_sched_stats(&after);
+  assert(after.boosts == before.boosts + 1);
+  err = thread_join(th, NULL);
+  assert(!err);
+  err = thread_join(th2, NULL);
+  assert(!err);
+  assert(pos == 2 && order[0] == 1 && order[1] == 2);
+  thread_cond_destroy(&cond);
+  thread_mutex_destroy(&mutex);
+
+  printf("tranches adaptatives OK\n");
+  return EXIT_SUCCESS;
+}
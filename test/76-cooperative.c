@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "thread.h"
+
+/* test de la préemption coopérative.
+ *
+ * en mode coopératif, aucun SIGVTALRM ne doit être reçu : un thread qui
+ * tourne sans passer la main mais appelle thread_maybe_yield() à chaque tour
+ * doit tout de même rendre le processeur à la fin de sa tranche.
+ * la durée des tests de thread_should_yield() est affichée.
+ *
+ * support nécessaire:
+ * - thread_create()
+ * - thread_yield()
+ * - thread_join() sans récupération de la valeur de retour
+ * - thread_set_preempt_mode(), thread_maybe_yield(), thread_should_yield()
+ * - thread_get_sched_stats()
+ * - préemption
+ */
+
+static volatile int stop = 0;
+static volatile int signals = 0;
+static volatile unsigned long turns = 0;
+
+static void count_signal(int sig __attribute__((unused)))
+{
+  signals++;
+}
+
+static void * spin(void *arg __attribute__((unused)))
+{
+  while (!stop) {
+    turns++;
+    thread_maybe_yield();
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  thread_sched_stats_t before, after;
+  struct timeval tv1, tv2;
+  unsigned long i, nb = 10000000, us, yields = 0;
+  thread_t th;
+  int err;
+
+  if (argc >= 2) {
+    nb = atol(argv[1]);
+  }
+
+  /* coût du test sur le chemin rapide */
+  gettimeofday(&tv1, NULL);
+  for (i = 0; i < nb; i++) {
+    yields += thread_should_yield();
+  }
+  gettimeofday(&tv2, NULL);
+  us = (tv2.tv_sec-tv1.tv_sec)*1000000+(tv2.tv_usec-tv1.tv_usec);
+  printf("%lu thread_should_yield() en %lu us (%lu vrais)\n", nb, us, yields);
+
+#ifdef PREEMPTION
+  assert(thread_set_preempt_mode(-1) == -1);
+  err = thread_set_preempt_mode(THREAD_PREEMPT_COOPERATIVE);
+  assert(!err);
+  signal(SIGVTALRM, count_signal);
+
+  err = thread_create(&th, spin, NULL);
+  assert(!err);
+  thread_get_sched_stats(&before);
+  /* le thread ne rend la main qu'à la fin de sa tranche */
+  thread_yield();
+  thread_get_sched_stats(&after);
+  assert(turns > 0);
+  assert(after.preemptions > before.preemptions);
+  stop = 1;
+  err = thread_join(th, NULL);
+  assert(!err);
+  assert(signals == 0);
+
+  err = thread_set_preempt_mode(THREAD_PREEMPT_SIGNAL);
+  assert(!err);
+  printf("préemption coopérative après %lu tours, sans signal\n", turns);
+#else
+  (void) th;
+  (void) err;
+  (void) before;
+  (void) after;
+  (void) spin;
+  (void) count_signal;
+#endif
+  return EXIT_SUCCESS;
+}
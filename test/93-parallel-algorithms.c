@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/time.h>
+#include <thread.h>
+#include <parallel.h>
+
+/*
+ * Algorithmes parallèles : somme, préfixe, transformation et tri d'un tableau,
+ * comparés aux versions séquentielles équivalentes (durées affichées).
+ * valgrind doit être content.
+ *
+ * support nécessaire:
+ * - parallel_for(), parallel_reduce(), parallel_scan(), parallel_sort()
+ */
+
+struct pair {
+  int key;
+  int order;
+};
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void sum_body(size_t begin, size_t end, void *partial, void *arg)
+{
+  const int *arr = arg;
+  long *sum = partial;
+  for (size_t i = begin; i < end; i++)
+    *sum += arr[i];
+}
+
+static void sum_combine(void *into, const void *from, void *arg __attribute__((unused)))
+{
+  *(long *) into += *(const long *) from;
+}
+
+static void double_body(size_t begin, size_t end, void *arg)
+{
+  long *arr = arg;
+  for (size_t i = begin; i < end; i++)
+    arr[i] *= 2;
+}
+
+static int compare_pairs(const void *a, const void *b)
+{
+  return ((const struct pair *) a)->key - ((const struct pair *) b)->key;
+}
+
+int main(int argc, char **argv)
+{
+  size_t i, size = 1000000;
+  int max = 1000, err;
+  int *arr;
+  long *prefix, sum, expected;
+  struct pair *pairs, *sorted;
+  const long zero = 0;
+  double t0, t1, t2;
+
+  if (argc >= 2) {
+    size = atol(argv[1]);
+  }
+  arr = malloc(size * sizeof(*arr));
+  prefix = malloc(size * sizeof(*prefix));
+  pairs = malloc(size * sizeof(*pairs));
+  sorted = malloc(size * sizeof(*sorted));
+  assert(arr && prefix && pairs && sorted);
+  srand(42);
+  for (i = 0; i < size; i++) {
+    arr[i] = rand() % max;
+    prefix[i] = arr[i];
+    pairs[i].key = rand() % max;
+    pairs[i].order = (int) i;
+  }
+  printf("grain automatique pour %zu éléments: %zu\n", size, parallel_grain(size));
+
+  /* réduction */
+  t0 = now();
+  expected = 0;
+  for (i = 0; i < size; i++)
+    expected += arr[i];
+  t1 = now();
+  sum = 0;
+  err = parallel_reduce(0, size, PARALLEL_GRAIN_AUTO, &sum, sizeof(sum), sum_body, sum_combine, arr);
+  assert(!err);
+  t2 = now();
+  assert(sum == expected);
+  printf("somme: séquentiel %e s, parallel_reduce %e s\n", t1 - t0, t2 - t1);
+
+  /* préfixe puis transformation */
+  t1 = now();
+  err = parallel_scan(prefix, size, sizeof(*prefix), &zero, sum_combine, NULL);
+  assert(!err);
+  t2 = now();
+  assert(prefix[size - 1] == expected);
+  for (i = 1; i < size; i++)
+    assert(prefix[i] == prefix[i - 1] + arr[i]);
+  printf("préfixe: parallel_scan %e s\n", t2 - t1);
+  err = parallel_for(0, size, 1000, double_body, prefix);
+  assert(!err);
+  assert(prefix[size - 1] == 2 * expected);
+
+  /* tri stable */
+  memcpy(sorted, pairs, size * sizeof(*pairs));
+  t0 = now();
+  qsort(pairs, size, sizeof(*pairs), compare_pairs);
+  t1 = now();
+  err = parallel_sort(sorted, size, sizeof(*sorted), compare_pairs);
+  assert(!err);
+  t2 = now();
+  for (i = 1; i < size; i++) {
+    assert(sorted[i - 1].key <= sorted[i].key);
+    assert(sorted[i - 1].key < sorted[i].key || sorted[i - 1].order < sorted[i].order);
+    assert(sorted[i].key == pairs[i].key);
+  }
+  printf("tri: qsort %e s, parallel_sort %e s\n", t1 - t0, t2 - t1);
+
+  free(arr);
+  free(prefix);
+  free(pairs);
+  free(sorted);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <sys/time.h>
+#include <thread.h>
+#include <parallel.h>
+
+/*
+ * Réductions vectorielles : somme, minimum, maximum et produit scalaire
+ * d'un tableau, avec chacun des jeux d'instructions disponibles, comparés
+ * à une boucle séquentielle (durées et débits affichés).
+ * Les valeurs sont entières pour que toutes les sommes soient exactes.
+ *
+ * support nécessaire:
+ * - parallel_sum(), parallel_min(), parallel_max(), parallel_dot(), parallel_sum_int()
+ * - parallel_kernel_select(), parallel_kernel_isa()
+ */
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main(int argc, char **argv)
+{
+  static const char *isas[] = {"scalar", "sse2", "avx2"};
+  size_t i, size = 4000000;
+  double *x, *y, sum = 0, min = INFINITY, max = -INFINITY, dot = 0, t0, t1;
+  int *ints;
+  long isum = 0;
+  unsigned k;
+
+  if (argc >= 2) {
+    size = atol(argv[1]);
+  }
+  x = malloc(size * sizeof(*x));
+  y = malloc(size * sizeof(*y));
+  ints = malloc(size * sizeof(*ints));
+  assert(x && y && ints);
+  srand(42);
+  for (i = 0; i < size; i++) {
+    x[i] = rand() % 1000 - 500;
+    y[i] = rand() % 16;
+    ints[i] = rand() - RAND_MAX / 2;
+  }
+
+  t0 = now();
+  for (i = 0; i < size; i++)
+    sum += x[i];
+  t1 = now();
+  for (i = 0; i < size; i++) {
+    min = x[i] < min ? x[i] : min;
+    max = x[i] > max ? x[i] : max;
+    dot += x[i] * y[i];
+    isum += ints[i];
+  }
+  printf("somme séquentielle: %e s (%.2f Go/s)\n", t1 - t0, size * sizeof(*x) / (t1 - t0) / 1e9);
+
+  printf("détection: %s\n", parallel_kernel_isa());
+  for (k = 0; k < sizeof(isas) / sizeof(*isas); k++) {
+    if (parallel_kernel_select(isas[k]) != 0) {
+      printf("%s: non disponible\n", isas[k]);
+      continue;
+    }
+    assert(!strcmp(parallel_kernel_isa(), isas[k]));
+    t0 = now();
+    assert(parallel_sum(x, size) == sum);
+    t1 = now();
+    assert(parallel_min(x, size) == min);
+    assert(parallel_max(x, size) == max);
+    assert(parallel_dot(x, y, size) == dot);
+    assert(parallel_sum_int(ints, size) == isum);
+    /* tailles qui ne tombent pas sur un multiple de la largeur des vecteurs */
+    assert(parallel_sum(x, 7) == x[0] + x[1] + x[2] + x[3] + x[4] + x[5] + x[6]);
+    assert(parallel_min(x, 0) == INFINITY);
+    printf("%s: somme en %e s (%.2f Go/s)\n", isas[k], t1 - t0, size * sizeof(*x) / (t1 - t0) / 1e9);
+  }
+  parallel_kernel_select(NULL);
+
+  free(x);
+  free(y);
+  free(ints);
+  return EXIT_SUCCESS;
+}